@@ -11,15 +11,20 @@
 // Header files ----------------------------------------------------------------
 
 #include "circularBuffer.h"
-#if __CIRCULAR_BUFFER_H != 130
-	#error Error 101 - Version mismatch on header and source code files (circularBuffer).
+#if __CIRCULAR_BUFFER_H != 1
+	#error Error 101 - Build mismatch on header and source code files (circularBuffer).
 #endif
+#include <util/atomic.h>
 
+#ifndef CIRCULAR_BUFFER_STATIC_ONLY
 /* -----------------------------------------------------------------------------
- * Initializes the circular buffer, alocating memory.
+ * Initializes the circular buffer, alocating memory. The mode defines what
+ * happens when data is pushed into a full buffer: CIRCULAR_BUFFER_REJECT_NEWEST
+ * keeps the stored data and the push fails, CIRCULAR_BUFFER_OVERWRITE_OLDEST
+ * keeps the latest elements, dropping the oldest one.
  * -------------------------------------------------------------------------- */
 
-bool_t circularBufferInit(volatile circularBuffer_t * buffer, uint16 bufferSize, uint8 variableSize)
+bool_t circularBufferInit(volatile circularBuffer_t * buffer, uint16 bufferSize, uint8 variableSize, circularBufferMode_t mode)
 {
 	if(bufferSize == 0)
 		return FALSE;
@@ -34,12 +39,19 @@ bool_t circularBufferInit(volatile circularBuffer_t * buffer, uint16 bufferSize,
 	buffer->nextRead = 0;
 	buffer->nextWrite = 0;
 	buffer->occupation = 0;
+	buffer->mode = mode;
+#ifdef CIRCULAR_BUFFER_STATISTICS
+	memset((void *)&buffer->statistics, 0, sizeof(circularBufferStatistics_t));
+#endif
 
 	return TRUE;
 }
+#endif
 
 /* -----------------------------------------------------------------------------
- * Pushes data into circular buffer. The function returns FALSE if buffer is full.
+ * Pushes data into circular buffer. The function returns FALSE if buffer is
+ * full, unless the buffer works in CIRCULAR_BUFFER_OVERWRITE_OLDEST mode, when
+ * the oldest element is dropped to make room for the new one.
  * -------------------------------------------------------------------------- */
 
 bool_t circularBufferPushData(volatile circularBuffer_t * buffer, void * data)
@@ -47,6 +59,13 @@ bool_t circularBufferPushData(volatile circularBuffer_t * buffer, void * data)
     uint8 * castData = data;
     uint8 tempSize = buffer->varSize;
 
+	if((buffer->occupation != 0) && (buffer->nextWrite == buffer->nextRead) && (buffer->mode == CIRCULAR_BUFFER_OVERWRITE_OLDEST)){
+		circularBufferCountOverflow(buffer, 1);
+		buffer->nextRead += tempSize;
+		if(buffer->nextRead >= buffer->size)
+			buffer->nextRead = 0;
+		buffer->occupation--;
+	}
 	if(buffer->occupation == 0 || buffer->nextWrite != buffer->nextRead){
 		while(tempSize > 0) {
             buffer->data[buffer->nextWrite] = *castData;
@@ -56,9 +75,11 @@ bool_t circularBufferPushData(volatile circularBuffer_t * buffer, void * data)
 		}
 		buffer->nextWrite %= buffer->size;
 		buffer->occupation++;
+		circularBufferCountPush(buffer, 1);
 
 		return TRUE;
 	}
+	circularBufferCountOverflow(buffer, 1);
 	return FALSE;
 }
 
@@ -77,6 +98,7 @@ void * circularBufferPopData(volatile circularBuffer_t * buffer)
 	if(buffer->occupation > 0){
 		buffer->nextRead = (buffer->nextRead + buffer->varSize) % buffer->size;
 		buffer->occupation--;
+		circularBufferCountPop(buffer, 1);
 	}
 
 	return data;
@@ -94,3 +116,479 @@ bool_t circularBufferIsEmpty(volatile circularBuffer_t * buffer)
 
 	return FALSE;
 }
+
+/* -----------------------------------------------------------------------------
+ * Pushes up to count elements into the circular buffer, copying them in at
+ * most two segments. Returns the number of elements actually pushed, which is
+ * smaller than count if the buffer does not have enough free space. In
+ * CIRCULAR_BUFFER_OVERWRITE_OLDEST mode the oldest elements are dropped instead
+ * and only the newest elements that fit into the buffer are pushed.
+ * -------------------------------------------------------------------------- */
+
+uint16 circularBufferPushBlock(volatile circularBuffer_t * buffer, void * data, uint16 count)
+{
+	uint16 freeBytes = buffer->size - (buffer->occupation * buffer->varSize);
+	uint32 bytes = (uint32)count * buffer->varSize;
+	uint16 first;
+
+	if(bytes > freeBytes) {
+		if(buffer->mode == CIRCULAR_BUFFER_OVERWRITE_OLDEST) {
+			if(bytes > buffer->size) {			// Only the newest elements fit
+				data = (uint8 *)data + (uint16)(bytes - buffer->size);
+				bytes = buffer->size;
+				count = buffer->size / buffer->varSize;
+			}
+			first = bytes - freeBytes;			// Drops the oldest elements
+			circularBufferCountOverflow(buffer, first / buffer->varSize);
+			buffer->nextRead += first;
+			if(buffer->nextRead >= buffer->size)
+				buffer->nextRead -= buffer->size;
+			buffer->occupation -= first / buffer->varSize;
+		} else {
+			circularBufferCountOverflow(buffer, count - (freeBytes / buffer->varSize));
+			count = freeBytes / buffer->varSize;
+			bytes = (uint32)count * buffer->varSize;
+		}
+	}
+	if(count == 0)
+		return 0;
+
+	first = buffer->size - buffer->nextWrite;
+	if(first > bytes)
+		first = bytes;
+	memcpy(buffer->data + buffer->nextWrite, data, first);
+	memcpy(buffer->data, (uint8 *)data + first, bytes - first);
+	buffer->nextWrite = (bytes - first) ? (bytes - first) : (buffer->nextWrite + first);
+	if(buffer->nextWrite >= buffer->size)
+		buffer->nextWrite = 0;
+	buffer->occupation += count;
+	circularBufferCountPush(buffer, count);
+
+	return count;
+}
+
+/* -----------------------------------------------------------------------------
+ * Pops up to count elements from the circular buffer, copying them in at most
+ * two segments into data. Returns the number of elements actually popped.
+ * -------------------------------------------------------------------------- */
+
+uint16 circularBufferPopBlock(volatile circularBuffer_t * buffer, void * data, uint16 count)
+{
+	uint32 bytes;
+	uint16 first;
+
+	if(count > buffer->occupation)
+		count = buffer->occupation;
+	if(count == 0)
+		return 0;
+
+	bytes = (uint32)count * buffer->varSize;
+	first = buffer->size - buffer->nextRead;
+	if(first > bytes)
+		first = bytes;
+	memcpy(data, buffer->data + buffer->nextRead, first);
+	memcpy((uint8 *)data + first, buffer->data, bytes - first);
+	buffer->nextRead = (bytes - first) ? (bytes - first) : (buffer->nextRead + first);
+	if(buffer->nextRead >= buffer->size)
+		buffer->nextRead = 0;
+	buffer->occupation -= count;
+	circularBufferCountPop(buffer, count);
+
+	return count;
+}
+
+/* -----------------------------------------------------------------------------
+ * Returns a pointer to the oldest unread element and stores into count how
+ * many unread elements are stored contiguously from there. The data can be
+ * parsed straight from the buffer memory and must then be released by calling
+ * circularBufferCommitRead().
+ * -------------------------------------------------------------------------- */
+
+void * circularBufferPeekContiguous(volatile circularBuffer_t * buffer, uint16 * count)
+{
+	uint16 bytes;
+
+	if(buffer->occupation == 0) {
+		*count = 0;
+	} else {
+		if(buffer->nextWrite > buffer->nextRead)
+			bytes = buffer->nextWrite - buffer->nextRead;
+		else
+			bytes = buffer->size - buffer->nextRead;
+		*count = (buffer->varSize == 1) ? bytes : (bytes / buffer->varSize);
+	}
+
+	return buffer->data + buffer->nextRead;
+}
+
+/* -----------------------------------------------------------------------------
+ * Releases count elements obtained through circularBufferPeekContiguous().
+ * -------------------------------------------------------------------------- */
+
+void circularBufferCommitRead(volatile circularBuffer_t * buffer, uint16 count)
+{
+	uint16 aux16;
+
+	if(count > buffer->occupation)
+		count = buffer->occupation;
+
+	aux16 = buffer->nextRead + (count * buffer->varSize);
+	if(aux16 >= buffer->size)
+		aux16 -= buffer->size;
+	buffer->nextRead = aux16;
+	buffer->occupation -= count;
+	circularBufferCountPop(buffer, count);
+
+	return;
+}
+
+/* -----------------------------------------------------------------------------
+ * Returns a pointer to the first free element and stores into count how many
+ * free elements are available contiguously from there. The data can be written
+ * straight into the buffer memory and must then be published by calling
+ * circularBufferCommitWrite().
+ * -------------------------------------------------------------------------- */
+
+void * circularBufferReserveWrite(volatile circularBuffer_t * buffer, uint16 * count)
+{
+	uint16 bytes;
+
+	if((buffer->occupation * buffer->varSize) >= buffer->size) {
+		*count = 0;
+	} else {
+		if(buffer->nextWrite >= buffer->nextRead)
+			bytes = buffer->size - buffer->nextWrite;
+		else
+			bytes = buffer->nextRead - buffer->nextWrite;
+		*count = (buffer->varSize == 1) ? bytes : (bytes / buffer->varSize);
+	}
+
+	return buffer->data + buffer->nextWrite;
+}
+
+/* -----------------------------------------------------------------------------
+ * Publishes count elements written into the memory obtained through
+ * circularBufferReserveWrite().
+ * -------------------------------------------------------------------------- */
+
+void circularBufferCommitWrite(volatile circularBuffer_t * buffer, uint16 count)
+{
+	uint16 aux16;
+	uint16 freeBytes = buffer->size - (buffer->occupation * buffer->varSize);
+
+	if((uint32)count * buffer->varSize > freeBytes)
+		count = freeBytes / buffer->varSize;
+
+	aux16 = buffer->nextWrite + (count * buffer->varSize);
+	if(aux16 >= buffer->size)
+		aux16 -= buffer->size;
+	buffer->nextWrite = aux16;
+	buffer->occupation += count;
+	circularBufferCountPush(buffer, count);
+
+	return;
+}
+
+/* -----------------------------------------------------------------------------
+ * Copies the newest count elements of the circular buffer into data, in
+ * chronological order, without removing them. Returns the number of elements
+ * copied, which is smaller than count if the buffer holds fewer elements. If
+ * the producer is an ISR, its interrupt must be disabled during the call.
+ * -------------------------------------------------------------------------- */
+
+uint16 circularBufferSnapshot(volatile circularBuffer_t * buffer, void * data, uint16 count)
+{
+	uint16 bytes;
+	uint16 start;
+	uint16 first;
+
+	if(count > buffer->occupation)
+		count = buffer->occupation;
+	if(count == 0)
+		return 0;
+
+	bytes = count * buffer->varSize;
+	start = (buffer->nextWrite >= bytes) ? (buffer->nextWrite - bytes) : (buffer->nextWrite + buffer->size - bytes);
+	first = buffer->size - start;
+	if(first > bytes)
+		first = bytes;
+	memcpy(data, buffer->data + start, first);
+	memcpy((uint8 *)data + first, buffer->data, bytes - first);
+
+	return count;
+}
+
+/* -----------------------------------------------------------------------------
+ * Pushes a variable length message into a circular buffer of 1-byte elements.
+ * The message is stored with a length prefix and is never split around the
+ * end of the buffer: if it does not fit in the remaining space, that space is
+ * padded and the message is stored at the beginning of the buffer. Buffer
+ * indexes are only updated after the whole message is written, so a partial
+ * message is never visible to the consumer. Returns FALSE if the message does
+ * not fit, unless the buffer works in CIRCULAR_BUFFER_OVERWRITE_OLDEST mode,
+ * when the oldest messages are dropped to make room for the new one.
+ * -------------------------------------------------------------------------- */
+
+bool_t circularBufferPushMessage(volatile circularBuffer_t * buffer, void * data, uint8 length)
+{
+	uint16 needed;
+	uint16 tail;
+	uint16 position;
+	uint8 dropped;
+
+	if((buffer->varSize != 1) || (length == 0) || ((uint16)length + 1 > buffer->size))
+		return FALSE;
+
+	while(1) {
+		if(buffer->occupation == 0) {	// Restarts an empty buffer to avoid padding
+			buffer->nextRead = 0;
+			buffer->nextWrite = 0;
+		}
+		needed = (uint16)length + 1;
+		position = buffer->nextWrite;
+		tail = buffer->size - position;
+		if(tail < needed) {				// Pads the end of the buffer
+			needed += tail;
+			position = 0;
+		}
+		if(needed <= (buffer->size - buffer->occupation))
+			break;
+		if(buffer->mode != CIRCULAR_BUFFER_OVERWRITE_OLDEST) {
+			circularBufferCountOverflow(buffer, 1);
+			return FALSE;
+		}
+		circularBufferPeekMessage(buffer, &dropped);	// Drops the oldest message
+		circularBufferCommitMessage(buffer);
+		circularBufferCountOverflow(buffer, 1);
+	}
+
+	if(position == 0)
+		buffer->data[buffer->nextWrite] = 0;	// Padding marker
+	buffer->data[position] = length;
+	memcpy(buffer->data + position + 1, data, length);
+	position += (uint16)length + 1;
+	buffer->nextWrite = (position >= buffer->size) ? 0 : position;
+	buffer->occupation += needed;
+	circularBufferCountPush(buffer, 1);
+
+	return TRUE;
+}
+
+/* -----------------------------------------------------------------------------
+ * Returns a pointer to the payload of the oldest message of the circular
+ * buffer and stores its size into length. Since messages are never split, the
+ * payload can be parsed straight from the buffer memory and must then be
+ * released by calling circularBufferCommitMessage(). Returns NULL, with length
+ * zero, if there is no message into the buffer.
+ * -------------------------------------------------------------------------- */
+
+void * circularBufferPeekMessage(volatile circularBuffer_t * buffer, uint8 * length)
+{
+	*length = 0;
+	if(buffer->occupation == 0)
+		return NULL;
+
+	if(buffer->data[buffer->nextRead] == 0) {		// Skips the padding
+		buffer->occupation -= buffer->size - buffer->nextRead;
+		buffer->nextRead = 0;
+		if(buffer->occupation == 0)
+			return NULL;
+	}
+	*length = buffer->data[buffer->nextRead];
+
+	return buffer->data + buffer->nextRead + 1;
+}
+
+/* -----------------------------------------------------------------------------
+ * Releases the message obtained through circularBufferPeekMessage().
+ * -------------------------------------------------------------------------- */
+
+void circularBufferCommitMessage(volatile circularBuffer_t * buffer)
+{
+	uint16 aux16;
+
+	if(buffer->occupation == 0)
+		return;
+
+	aux16 = (uint16)buffer->data[buffer->nextRead] + 1;
+	buffer->occupation -= aux16;
+	circularBufferCountPop(buffer, 1);
+	aux16 += buffer->nextRead;
+	buffer->nextRead = (aux16 >= buffer->size) ? 0 : aux16;
+
+	return;
+}
+
+/* -----------------------------------------------------------------------------
+ * Pops the oldest message of the circular buffer, copying up to maxLength
+ * bytes of it into data. The whole message is removed from the buffer even if
+ * it is truncated. Returns the original size of the message, or zero if there
+ * is no message into the buffer.
+ * -------------------------------------------------------------------------- */
+
+uint8 circularBufferPopMessage(volatile circularBuffer_t * buffer, void * data, uint8 maxLength)
+{
+	uint8 length;
+	void * message = circularBufferPeekMessage(buffer, &length);
+
+	if(message == NULL)
+		return 0;
+
+	memcpy(data, message, (length > maxLength) ? maxLength : length);
+	circularBufferCommitMessage(buffer);
+
+	return length;
+}
+
+#ifdef CIRCULAR_BUFFER_STATISTICS
+/* -----------------------------------------------------------------------------
+ * Copies the usage counters of the circular buffer into statistics. The copy
+ * is made with interrupts disabled, so the counters are consistent even if an
+ * ISR is using the buffer.
+ * -------------------------------------------------------------------------- */
+
+void circularBufferGetStatistics(volatile circularBuffer_t * buffer, circularBufferStatistics_t * statistics)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		*statistics = buffer->statistics;
+	}
+
+	return;
+}
+
+/* -----------------------------------------------------------------------------
+ * Clears the usage counters of the circular buffer. The high-watermark is
+ * restarted from the current occupation.
+ * -------------------------------------------------------------------------- */
+
+void circularBufferResetStatistics(volatile circularBuffer_t * buffer)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		buffer->statistics.highWatermark = buffer->occupation;
+		buffer->statistics.pushCount = 0;
+		buffer->statistics.overflowCount = 0;
+		buffer->statistics.popCount = 0;
+	}
+
+	return;
+}
+#endif
+
+#ifndef CIRCULAR_BUFFER_STATIC_ONLY
+/* -----------------------------------------------------------------------------
+ * Initializes the single-producer/single-consumer circular buffer, alocating
+ * memory. The bufferSize is given in elements and must be a power of two not
+ * greater than CIRCULAR_BUFFER_SPSC_MAX_SIZE, so the indexes can be wrapped
+ * with a mask and read by the other side in a single 8-bit access.
+ * -------------------------------------------------------------------------- */
+
+bool_t circularBufferSpscInit(circularBufferSpsc_t * buffer, uint16 bufferSize, uint8 variableSize)
+{
+	if((bufferSize == 0) || (bufferSize > CIRCULAR_BUFFER_SPSC_MAX_SIZE))
+		return FALSE;
+	if((bufferSize & (bufferSize - 1)) != 0)
+		return FALSE;
+	if(variableSize == 0)
+		return FALSE;
+
+	// Memory allocation
+	buffer->data = (uint8 *)malloc(bufferSize * variableSize);
+	if(buffer->data == NULL)
+		return FALSE;
+
+	buffer->mask = (uint8)(bufferSize - 1);
+	buffer->varSize = variableSize;
+	buffer->head = 0;
+	buffer->tail = 0;
+
+	return TRUE;
+}
+#endif
+
+/* -----------------------------------------------------------------------------
+ * Pushes data into the SPSC circular buffer. Must only be called by the
+ * producer side (usually an ISR). The function returns FALSE if buffer is full.
+ * -------------------------------------------------------------------------- */
+
+bool_t circularBufferSpscPushData(circularBufferSpsc_t * buffer, void * data)
+{
+	uint8 * castData = data;
+	uint8 * slot;
+	uint8 tempSize = buffer->varSize;
+	uint8 head = buffer->head;
+
+	if((uint8)(head - buffer->tail) > buffer->mask)
+		return FALSE;
+
+	slot = buffer->data + (uint16)(head & buffer->mask) * tempSize;
+	while(tempSize > 0) {
+		*slot++ = *castData++;
+		tempSize--;
+	}
+	circularBufferMemoryBarrier();		// Data must be stored before it is published
+	buffer->head = head + 1;
+
+	return TRUE;
+}
+
+/* -----------------------------------------------------------------------------
+ * Pops data from the SPSC circular buffer, copying it into data. Must only be
+ * called by the consumer side. The function returns FALSE if buffer is empty.
+ * -------------------------------------------------------------------------- */
+
+bool_t circularBufferSpscPopData(circularBufferSpsc_t * buffer, void * data)
+{
+	uint8 * castData = data;
+	uint8 * slot;
+	uint8 tempSize = buffer->varSize;
+	uint8 tail = buffer->tail;
+
+	if(buffer->head == tail)
+		return FALSE;
+
+	slot = buffer->data + (uint16)(tail & buffer->mask) * tempSize;
+	while(tempSize > 0) {
+		*castData++ = *slot++;
+		tempSize--;
+	}
+	circularBufferMemoryBarrier();		// Data must be read before the slot is released
+	buffer->tail = tail + 1;
+
+	return TRUE;
+}
+
+/* -----------------------------------------------------------------------------
+ * Verifies if the SPSC circular buffer is empty. Returns TRUE if there is no
+ * unread data into buffer.
+ * -------------------------------------------------------------------------- */
+
+bool_t circularBufferSpscIsEmpty(circularBufferSpsc_t * buffer)
+{
+	if(buffer->head == buffer->tail)
+		return TRUE;
+
+	return FALSE;
+}
+
+/* -----------------------------------------------------------------------------
+ * Verifies if the SPSC circular buffer is full. Returns TRUE if a push would
+ * be rejected.
+ * -------------------------------------------------------------------------- */
+
+bool_t circularBufferSpscIsFull(circularBufferSpsc_t * buffer)
+{
+	if((uint8)(buffer->head - buffer->tail) > buffer->mask)
+		return TRUE;
+
+	return FALSE;
+}
+
+/* -----------------------------------------------------------------------------
+ * Returns the number of elements stored into the SPSC circular buffer. The
+ * value is a snapshot, since the other side can change it at any time.
+ * -------------------------------------------------------------------------- */
+
+uint8 circularBufferSpscGetOccupation(circularBufferSpsc_t * buffer)
+{
+	return (uint8)(buffer->head - buffer->tail);
+}
@@ -8,40 +8,188 @@
  * -------------------------------------------------------------------------- */
 
 #ifndef __CIRCULAR_BUFFER_H
-#define __CIRCULAR_BUFFER_H 130
+#define __CIRCULAR_BUFFER_H 1
 
 // -----------------------------------------------------------------------------
 // Header files ----------------------------------------------------------------
 
 #include "globalDefines.h"
-#if __GLOBALDEFINES_H != 130
-	#error Error 100 - globalDefines.h - wrong version (globalDefines must be version 13.0).
+#if __GLOBALDEFINES_H != 1
+	#error Error 100 - globalDefines.h - wrong build (globalDefines must be build 1).
 #endif
 #include <stdlib.h>
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+// Constant definitions --------------------------------------------------------
+
+#define CIRCULAR_BUFFER_SPSC_MAX_SIZE	128
+
+// Define CIRCULAR_BUFFER_STATIC_ONLY to remove the malloc() based
+// initialization functions, so the allocator is never linked into the image.
+// Buffers must then be declared with the createStaticCircularBuffer*() macros.
+
+// Define CIRCULAR_BUFFER_STATISTICS to keep per-buffer usage counters
+// (high-watermark, pushes, rejected pushes and pops) in circularBuffer_t.
+// Message functions count whole messages, but the high-watermark is always
+// given in storage units, including length prefixes and padding.
 
 // -----------------------------------------------------------------------------
 // New data types --------------------------------------------------------------
 
+typedef enum circularBufferMode_t{
+	CIRCULAR_BUFFER_REJECT_NEWEST = 0,		// Push on a full buffer fails
+	CIRCULAR_BUFFER_OVERWRITE_OLDEST = 1	// Push on a full buffer drops the oldest element
+} circularBufferMode_t;
+
+typedef struct circularBufferStatistics_t{
+	uint16 highWatermark;
+	uint32 pushCount;
+	uint32 overflowCount;
+	uint32 popCount;
+} circularBufferStatistics_t;
+
 typedef struct circularBuffer_t{
 	uint16 nextRead;
 	uint16 nextWrite;
 	uint16 size;
 	uint8 varSize;
-	uint8 occupation;
+	uint16 occupation;
+	circularBufferMode_t mode;
 	uint8 * data;
+#ifdef CIRCULAR_BUFFER_STATISTICS
+	circularBufferStatistics_t statistics;
+#endif
 } circularBuffer_t;
 
+typedef struct circularBufferSpsc_t{
+	vuint8 head;			// Written only by the producer
+	vuint8 tail;			// Written only by the consumer
+	uint8 mask;
+	uint8 varSize;
+	uint8 * data;
+} circularBufferSpsc_t;
+
 // -----------------------------------------------------------------------------
 // Macrofunctions --------------------------------------------------------------
 
-#define createCircularBuffer(object) volatile circularBuffer_t object = {.nextRead = 0, .nextWrite = 0, .size = 0, .occupation = 0, .data = NULL}
+#define createCircularBuffer(object) volatile circularBuffer_t object = {.nextRead = 0, .nextWrite = 0, .size = 0, .occupation = 0, .mode = CIRCULAR_BUFFER_REJECT_NEWEST, .data = NULL}
+#define createCircularBufferSpsc(object) circularBufferSpsc_t object = {.head = 0, .tail = 0, .mask = 0, .varSize = 0, .data = NULL}
+#define circularBufferMemoryBarrier() __asm__ __volatile__("" ::: "memory")
+
+#ifdef CIRCULAR_BUFFER_STATISTICS
+	#define circularBufferCountPush(buffer, count)		do{																\
+			(buffer)->statistics.pushCount += (count);																	\
+			if((buffer)->occupation > (buffer)->statistics.highWatermark)												\
+				(buffer)->statistics.highWatermark = (buffer)->occupation;												\
+		}while(0)
+	#define circularBufferCountOverflow(buffer, count)	((buffer)->statistics.overflowCount += (count))
+	#define circularBufferCountPop(buffer, count)		((buffer)->statistics.popCount += (count))
+#else
+	#define circularBufferCountPush(buffer, count)		do{}while(0)
+	#define circularBufferCountOverflow(buffer, count)	do{}while(0)
+	#define circularBufferCountPop(buffer, count)		do{}while(0)
+#endif
+
+// Declares a circular buffer with statically allocated storage for length
+// elements of the given type, working in the given circularBufferMode_t, and
+// the inline functions objectPush(value) and objectPop(&value), which copy one
+// element without any loop or division.
+#define createStaticCircularBuffer(object, type, length, bufferMode)											\
+	static type object##Storage[(length)];																		\
+	volatile circularBuffer_t object = {.nextRead = 0, .nextWrite = 0, .size = (length) * sizeof(type),		\
+			.varSize = sizeof(type), .occupation = 0, .mode = (bufferMode), .data = (uint8 *)object##Storage};	\
+	static inline bool_t object##Push(type value)																\
+	{																											\
+		uint16 aux16 = object.nextWrite;																		\
+		if(object.occupation >= (length)) {																		\
+			circularBufferCountOverflow(&object, 1);															\
+			if((bufferMode) != CIRCULAR_BUFFER_OVERWRITE_OLDEST)												\
+				return FALSE;																					\
+			object.nextRead = (aux16 + sizeof(type) >= (length) * sizeof(type)) ? 0 : (aux16 + sizeof(type));	\
+			object.occupation--;																				\
+		}																										\
+		*(type *)((uint8 *)object##Storage + aux16) = value;													\
+		aux16 += sizeof(type);																					\
+		object.nextWrite = (aux16 >= (length) * sizeof(type)) ? 0 : aux16;										\
+		object.occupation++;																					\
+		circularBufferCountPush(&object, 1);																	\
+		return TRUE;																							\
+	}																											\
+	static inline bool_t object##Pop(type * value)																\
+	{																											\
+		uint16 aux16 = object.nextRead;																			\
+		if(object.occupation == 0)																				\
+			return FALSE;																						\
+		*value = *(type *)((uint8 *)object##Storage + aux16);													\
+		aux16 += sizeof(type);																					\
+		object.nextRead = (aux16 >= (length) * sizeof(type)) ? 0 : aux16;										\
+		object.occupation--;																					\
+		circularBufferCountPop(&object, 1);																		\
+		return TRUE;																							\
+	}
+
+// Declares a SPSC circular buffer with statically allocated storage for
+// length elements of the given type (power of two), and the inline functions
+// objectPush(value) and objectPop(&value).
+#define createStaticCircularBufferSpsc(object, type, length)													\
+	_Static_assert((((length) & ((length) - 1)) == 0) && ((length) > 0) &&										\
+			((length) <= CIRCULAR_BUFFER_SPSC_MAX_SIZE), "SPSC buffer length must be a power of two up to 128");	\
+	static type object##Storage[(length)];																		\
+	circularBufferSpsc_t object = {.head = 0, .tail = 0, .mask = (length) - 1, .varSize = sizeof(type),			\
+			.data = (uint8 *)object##Storage};																	\
+	static inline bool_t object##Push(type value)																\
+	{																											\
+		uint8 head = object.head;																				\
+		if((uint8)(head - object.tail) > (uint8)((length) - 1))													\
+			return FALSE;																						\
+		object##Storage[head & ((length) - 1)] = value;															\
+		circularBufferMemoryBarrier();																			\
+		object.head = head + 1;																					\
+		return TRUE;																							\
+	}																											\
+	static inline bool_t object##Pop(type * value)																\
+	{																											\
+		uint8 tail = object.tail;																				\
+		if(object.head == tail)																					\
+			return FALSE;																						\
+		*value = object##Storage[tail & ((length) - 1)];														\
+		circularBufferMemoryBarrier();																			\
+		object.tail = tail + 1;																					\
+		return TRUE;																							\
+	}
 
 // -----------------------------------------------------------------------------
 // Function declarations -------------------------------------------------------
 
-bool_t	circularBufferInit(volatile circularBuffer_t * buffer, uint16 bufferSize, uint8 variableSize);
+#ifndef CIRCULAR_BUFFER_STATIC_ONLY
+bool_t	circularBufferInit(volatile circularBuffer_t * buffer, uint16 bufferSize, uint8 variableSize, circularBufferMode_t mode);
+#endif
 bool_t	circularBufferPushData(volatile circularBuffer_t * buffer, void * data);
 void *	circularBufferPopData(volatile circularBuffer_t * buffer);
 bool_t	circularBufferIsEmpty(volatile circularBuffer_t * buffer);
+uint16	circularBufferPushBlock(volatile circularBuffer_t * buffer, void * data, uint16 count);
+uint16	circularBufferPopBlock(volatile circularBuffer_t * buffer, void * data, uint16 count);
+void *	circularBufferPeekContiguous(volatile circularBuffer_t * buffer, uint16 * count);
+void	circularBufferCommitRead(volatile circularBuffer_t * buffer, uint16 count);
+void *	circularBufferReserveWrite(volatile circularBuffer_t * buffer, uint16 * count);
+void	circularBufferCommitWrite(volatile circularBuffer_t * buffer, uint16 count);
+uint16	circularBufferSnapshot(volatile circularBuffer_t * buffer, void * data, uint16 count);
+bool_t	circularBufferPushMessage(volatile circularBuffer_t * buffer, void * data, uint8 length);
+uint8	circularBufferPopMessage(volatile circularBuffer_t * buffer, void * data, uint8 maxLength);
+void *	circularBufferPeekMessage(volatile circularBuffer_t * buffer, uint8 * length);
+void	circularBufferCommitMessage(volatile circularBuffer_t * buffer);
+#ifdef CIRCULAR_BUFFER_STATISTICS
+void	circularBufferGetStatistics(volatile circularBuffer_t * buffer, circularBufferStatistics_t * statistics);
+void	circularBufferResetStatistics(volatile circularBuffer_t * buffer);
+#endif
+#ifndef CIRCULAR_BUFFER_STATIC_ONLY
+bool_t	circularBufferSpscInit(circularBufferSpsc_t * buffer, uint16 bufferSize, uint8 variableSize);
+#endif
+bool_t	circularBufferSpscPushData(circularBufferSpsc_t * buffer, void * data);
+bool_t	circularBufferSpscPopData(circularBufferSpsc_t * buffer, void * data);
+bool_t	circularBufferSpscIsEmpty(circularBufferSpsc_t * buffer);
+bool_t	circularBufferSpscIsFull(circularBufferSpsc_t * buffer);
+uint8	circularBufferSpscGetOccupation(circularBufferSpsc_t * buffer);
 
 #endif
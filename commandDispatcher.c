@@ -0,0 +1,75 @@
+/* -----------------------------------------------------------------------------
+ * Project:			GPDSE AVR8 Library
+ * File:			commandDispatcher.c
+ * Module:			Table-driven command dispatcher
+ * Author:			Leandro Schwarz
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			Matches the first word of a text line against a sorted
+ *					table of keywords stored in program memory (binary search)
+ *					and calls the associated handler with the rest of the line
+ * -------------------------------------------------------------------------- */
+
+// -----------------------------------------------------------------------------
+// Header files ----------------------------------------------------------------
+
+#include "commandDispatcher.h"
+#if __COMMAND_DISPATCHER_H != 1
+	#error Error 101 - Build mismatch on header and source code files (commandDispatcher).
+#endif
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+// Public function definitions -------------------------------------------------
+
+/* -----------------------------------------------------------------------------
+ * Function:	commandDispatch
+ * Purpose:		Splits the line into keyword and arguments (separated by
+ * 				spaces) and calls the handler of the matching table entry
+ * Arguments:	table			sorted command table, in program memory
+ * 				tableSize		number of entries of the table
+ * 				line			null-terminated line (modified in place)
+ * Returns:		TRUE if the keyword was found and the handler called
+ * -------------------------------------------------------------------------- */
+
+bool_t commandDispatch(const commandEntry_t * table, uint8 tableSize, char * line)
+{
+	char * arguments;
+	commandHandler_t handler;
+	uint8 first = 0;
+	uint8 last = tableSize;
+	uint8 middle;
+	int16 compare;
+
+	// Separates the keyword from the arguments
+	while(*line == ' ')
+		line++;
+	if(*line == '\0')
+		return FALSE;
+	arguments = line;
+	while((*arguments != ' ') && (*arguments != '\0'))
+		arguments++;
+	if(*arguments != '\0') {
+		*arguments++ = '\0';
+		while(*arguments == ' ')
+			arguments++;
+	}
+
+	// Binary search on the keywords
+	while(first < last) {
+		middle = first + ((last - first) >> 1);
+		compare = strcmp_P(line, table[middle].keyword);
+		if(compare == 0) {
+			handler = (commandHandler_t)pgm_read_ptr(&table[middle].handler);
+			handler(arguments);
+			return TRUE;
+		}
+		if(compare < 0) {
+			last = middle;
+		} else {
+			first = middle + 1;
+		}
+	}
+
+	return FALSE;
+}
@@ -0,0 +1,60 @@
+/* -----------------------------------------------------------------------------
+ * Project:			GPDSE AVR8 Library
+ * File:			commandDispatcher.h
+ * Module:			Table-driven command dispatcher
+ * Author:			Leandro Schwarz
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			Matches the first word of a text line against a sorted
+ *					table of keywords stored in program memory (binary search)
+ *					and calls the associated handler with the rest of the line
+ * Usage:			const commandEntry_t commandTable[] PROGMEM = {
+ *						{"get",		getHandler},
+ *						{"reset",	resetHandler},
+ *						{"set",		setHandler}
+ *					};
+ *					commandDispatch(commandTable, commandTableSize(commandTable), line);
+ *					The entries must be sorted by keyword, in strcmp() order.
+ * -------------------------------------------------------------------------- */
+
+#ifndef __COMMAND_DISPATCHER_H
+#define __COMMAND_DISPATCHER_H 1
+
+// -----------------------------------------------------------------------------
+// Header files ----------------------------------------------------------------
+
+#include "globalDefines.h"
+#if __GLOBALDEFINES_H != 1
+	#error Error 100 - globalDefines.h - wrong build (globalDefines must be build 1).
+#endif
+#include <avr/pgmspace.h>
+
+// -----------------------------------------------------------------------------
+// Constant definitions --------------------------------------------------------
+
+// Maximum keyword length, including the string terminator
+#ifndef COMMAND_KEYWORD_SIZE
+	#define COMMAND_KEYWORD_SIZE		8
+#endif
+
+// -----------------------------------------------------------------------------
+// New data types --------------------------------------------------------------
+
+typedef void (* commandHandler_t)(char * arguments);
+
+typedef struct commandEntry_t {
+	char keyword[COMMAND_KEYWORD_SIZE];
+	commandHandler_t handler;
+} commandEntry_t;
+
+// -----------------------------------------------------------------------------
+// Macrofunctions --------------------------------------------------------------
+
+#define commandTableSize(table)		(sizeof(table) / sizeof(commandEntry_t))
+
+// -----------------------------------------------------------------------------
+// Function declarations -------------------------------------------------------
+
+bool_t	commandDispatch(const commandEntry_t * table, uint8 tableSize, char * line);
+
+#endif
@@ -0,0 +1,235 @@
+/* -----------------------------------------------------------------------------
+ * Project:			GPDSE AVR8 Library
+ * File:			fmt.c
+ * Module:			Integer and fixed-point formatting
+ * Author:			Leandro Schwarz
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			Lightweight replacement for printf() number conversions.
+ *					Every function writes a null-terminated string and returns
+ *					a pointer to its terminator, so calls can be chained and the
+ *					result sent to any output (usartWrite(), LCD stream, etc.)
+ * -------------------------------------------------------------------------- */
+
+// -----------------------------------------------------------------------------
+// Header files ----------------------------------------------------------------
+
+#include "fmt.h"
+#if __FMT_H != 1
+	#error Error 101 - Build mismatch on header and source code files (fmt).
+#endif
+
+// -----------------------------------------------------------------------------
+// Private functions declaration -----------------------------------------------
+
+static char * fmtUnsigned(char * string, uint32 value, uint8 bits, uint8 minDigits);
+
+// -----------------------------------------------------------------------------
+// Public function definitions -------------------------------------------------
+
+/* -----------------------------------------------------------------------------
+ * Function:	fmtU16
+ * Purpose:		Writes an unsigned 16-bit value in decimal
+ * Arguments:	string			destination (6 bytes)
+ * 				value			value to be converted
+ * Returns:		pointer to the string terminator
+ * -------------------------------------------------------------------------- */
+
+char * fmtU16(char * string, uint16 value)
+{
+	return fmtUnsigned(string, value, 16, 1);
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	fmtI16
+ * Purpose:		Writes a signed 16-bit value in decimal
+ * Arguments:	string			destination (7 bytes)
+ * 				value			value to be converted
+ * Returns:		pointer to the string terminator
+ * -------------------------------------------------------------------------- */
+
+char * fmtI16(char * string, int16 value)
+{
+	if(value < 0) {
+		*string++ = '-';
+		return fmtUnsigned(string, (uint16)0 - (uint16)value, 16, 1);
+	}
+	return fmtUnsigned(string, (uint16)value, 16, 1);
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	fmtU32
+ * Purpose:		Writes an unsigned 32-bit value in decimal
+ * Arguments:	string			destination (11 bytes)
+ * 				value			value to be converted
+ * Returns:		pointer to the string terminator
+ * -------------------------------------------------------------------------- */
+
+char * fmtU32(char * string, uint32 value)
+{
+	return fmtUnsigned(string, value, 32, 1);
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	fmtI32
+ * Purpose:		Writes a signed 32-bit value in decimal
+ * Arguments:	string			destination (12 bytes)
+ * 				value			value to be converted
+ * Returns:		pointer to the string terminator
+ * -------------------------------------------------------------------------- */
+
+char * fmtI32(char * string, int32 value)
+{
+	if(value < 0) {
+		*string++ = '-';
+		return fmtUnsigned(string, (uint32)0 - (uint32)value, 32, 1);
+	}
+	return fmtUnsigned(string, (uint32)value, 32, 1);
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	fmtHex8
+ * Purpose:		Writes an 8-bit value as two uppercase hexadecimal digits
+ * Arguments:	string			destination (3 bytes)
+ * 				value			value to be converted
+ * Returns:		pointer to the string terminator
+ * -------------------------------------------------------------------------- */
+
+char * fmtHex8(char * string, uint8 value)
+{
+	uint8 nibble;
+
+	nibble = value >> 4;
+	*string++ = (nibble < 10) ? ('0' + nibble) : ('A' - 10 + nibble);
+	nibble = value & 0x0F;
+	*string++ = (nibble < 10) ? ('0' + nibble) : ('A' - 10 + nibble);
+	*string = '\0';
+
+	return string;
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	fmtHex16
+ * Purpose:		Writes a 16-bit value as four uppercase hexadecimal digits
+ * Arguments:	string			destination (5 bytes)
+ * 				value			value to be converted
+ * Returns:		pointer to the string terminator
+ * -------------------------------------------------------------------------- */
+
+char * fmtHex16(char * string, uint16 value)
+{
+	string = fmtHex8(string, (uint8)(value >> 8));
+	return fmtHex8(string, (uint8)value);
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	fmtFixed
+ * Purpose:		Writes a signed fixed-point value in decimal, rounded to the
+ * 				given number of fractional digits
+ * Arguments:	string			destination (18 bytes)
+ * 				q				fixed-point value, with fracBits fractional bits
+ * 				fracBits		number of fractional bits of q (up to
+ * 								FMT_MAX_FRACTION_BITS)
+ * 				digits			number of decimal places (up to
+ * 								FMT_MAX_FRACTION_DIGITS)
+ * Returns:		pointer to the string terminator
+ * -------------------------------------------------------------------------- */
+
+char * fmtFixed(char * string, int32 q, uint8 fracBits, uint8 digits)
+{
+	uint32 magnitude = (q < 0) ? ((uint32)0 - (uint32)q) : (uint32)q;
+	uint32 integer;
+	uint32 fraction;
+	uint16 scale = 1;
+	uint8 i;
+
+	if(fracBits > FMT_MAX_FRACTION_BITS)
+		fracBits = FMT_MAX_FRACTION_BITS;
+	if(digits > FMT_MAX_FRACTION_DIGITS)
+		digits = FMT_MAX_FRACTION_DIGITS;
+	for(i = 0;i < digits;i++)
+		scale *= 10;
+
+	integer = magnitude >> fracBits;
+	fraction = magnitude & (((uint32)1 << fracBits) - 1);
+	// fraction * scale fits in 32 bits, since fraction < 2^16 and scale <= 10^4
+	fraction = ((fraction * scale) + (((uint32)1 << fracBits) >> 1)) >> fracBits;
+	if(fraction >= scale) {		// Rounding carried into the integer part
+		fraction -= scale;
+		integer++;
+	}
+
+	if((q < 0) && ((integer != 0) || (fraction != 0)))
+		*string++ = '-';
+	string = fmtUnsigned(string, integer, 32, 1);
+	if(digits > 0) {
+		*string++ = '.';
+		string = fmtUnsigned(string, fraction, 16, digits);
+	}
+
+	return string;
+}
+
+// -----------------------------------------------------------------------------
+// Private function definitions ------------------------------------------------
+
+/* -----------------------------------------------------------------------------
+ * Function:	fmtUnsigned
+ * Purpose:		Converts the lower bits of value to packed BCD using the
+ * 				shift-add-3 algorithm (the same used by bin2BCD16 in lcd8d.asm)
+ * 				and writes the decimal digits
+ * Arguments:	string			destination
+ * 				value			value to be converted
+ * 				bits			number of significant bits of value (16 or 32)
+ * 				minDigits		minimum number of digits (zero padded)
+ * Returns:		pointer to the string terminator
+ * -------------------------------------------------------------------------- */
+
+static char * fmtUnsigned(char * string, uint32 value, uint8 bits, uint8 minDigits)
+{
+	uint8 bcd[5] = {0, 0, 0, 0, 0};		// Least significant pair of digits first
+	uint8 bcdSize = (bits > 16) ? 5 : 3;
+	uint8 carry;
+	uint8 aux8;
+	uint8 i;
+	bool_t leading = TRUE;
+
+	// Skips the leading zero bits
+	while((bits > 0) && !(value & ((uint32)1 << (bits - 1))))
+		bits--;
+	value <<= (32 - bits) & 0x1F;
+
+	while(bits > 0) {
+		// Adds 3 to every BCD digit greater than 4
+		for(i = 0;i < bcdSize;i++) {
+			aux8 = bcd[i];
+			if((aux8 & 0x0F) >= 0x05)
+				aux8 += 0x03;
+			if((aux8 & 0xF0) >= 0x50)
+				aux8 += 0x30;
+			bcd[i] = aux8;
+		}
+		// Shifts the next bit of value into the BCD digits
+		carry = (value & 0x80000000UL) ? 1 : 0;
+		value <<= 1;
+		for(i = 0;i < bcdSize;i++) {
+			aux8 = bcd[i] >> 7;
+			bcd[i] = (bcd[i] << 1) | carry;
+			carry = aux8;
+		}
+		bits--;
+	}
+
+	// Writes the digits, most significant first
+	for(i = bcdSize * 2;i > 0;i--) {
+		aux8 = bcd[(i - 1) >> 1];
+		aux8 = ((i - 1) & 1) ? (aux8 >> 4) : (aux8 & 0x0F);
+		if(leading && (aux8 == 0) && (i > minDigits))
+			continue;
+		leading = FALSE;
+		*string++ = '0' + aux8;
+	}
+	*string = '\0';
+
+	return string;
+}
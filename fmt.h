@@ -0,0 +1,42 @@
+/* -----------------------------------------------------------------------------
+ * Project:			GPDSE AVR8 Library
+ * File:			fmt.h
+ * Module:			Integer and fixed-point formatting
+ * Author:			Leandro Schwarz
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			Lightweight replacement for printf() number conversions.
+ *					Every function writes a null-terminated string and returns
+ *					a pointer to its terminator, so calls can be chained and the
+ *					result sent to any output (usartWrite(), LCD stream, etc.)
+ * -------------------------------------------------------------------------- */
+
+#ifndef __FMT_H
+#define __FMT_H 1
+
+// -----------------------------------------------------------------------------
+// Header files ----------------------------------------------------------------
+
+#include "globalDefines.h"
+#if __GLOBALDEFINES_H != 1
+	#error Error 100 - globalDefines.h - wrong build (globalDefines must be build 1).
+#endif
+
+// -----------------------------------------------------------------------------
+// Constant definitions --------------------------------------------------------
+
+#define FMT_MAX_FRACTION_BITS		16
+#define FMT_MAX_FRACTION_DIGITS		4
+
+// -----------------------------------------------------------------------------
+// Function declarations -------------------------------------------------------
+
+char *	fmtU16(char * string, uint16 value);
+char *	fmtI16(char * string, int16 value);
+char *	fmtU32(char * string, uint32 value);
+char *	fmtI32(char * string, int32 value);
+char *	fmtHex8(char * string, uint8 value);
+char *	fmtHex16(char * string, uint16 value);
+char *	fmtFixed(char * string, int32 q, uint8 fracBits, uint8 digits);
+
+#endif
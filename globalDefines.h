@@ -117,7 +117,7 @@ typedef enum resultValue_t {
 	RESULT_UNSUPPORTED_USART_PARITY,
 	RESULT_UNSUPPORTED_USART_DATA_BITS,
 	RESULT_UNSUPPORTED_USART_MODE,
-	RESULT_UNSUPPORTED_USART_BAUD_RATE,			// Not implemented yet
+	RESULT_UNSUPPORTED_USART_BAUD_RATE,
 	RESULT_UNSUPPORTED_TIMER_PORT_CONFIG,
 	RESULT_UNSUPPORTED_TIMER0_PRESCALER_VALUE,
 	RESULT_UNSUPPORTED_TIMER0_MODE,
@@ -0,0 +1,346 @@
+/* -----------------------------------------------------------------------------
+ * Project:			GPDSE AVR8 Library
+ * File:			modbusSlave.c
+ * Module:			Modbus RTU slave
+ * Author:			Leandro Schwarz
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			Modbus RTU slave engine over the buffered USART. Bytes are
+ *					collected and the CRC16 is updated by the USART_RX_vect
+ *					handler; the end of the frame (3.5 characters of silence)
+ *					is detected by the timer2 compare A interrupt. Supports the
+ *					function codes 3, 4, 6 and 16 through callbacks
+ * -------------------------------------------------------------------------- */
+
+// -----------------------------------------------------------------------------
+// Header files ----------------------------------------------------------------
+
+#include "modbusSlave.h"
+#if __MODBUS_SLAVE_H != 1
+	#error Error 101 - Build mismatch on header and source code files (modbusSlave).
+#endif
+#include "usart.h"
+#if __USART_H != 1
+	#error Error 100 - usart.h - wrong build (usart must be build 1).
+#endif
+#ifndef USART_BUFFERED_MODE
+	#error Error 104 - modbusSlave.c - USART_BUFFERED_MODE must be defined.
+#endif
+#include "timer2.h"
+#if __TIMER2_H != 1
+	#error Error 100 - timer2.h - wrong build (timer2 must be build 1).
+#endif
+#include <avr/pgmspace.h>
+
+// -----------------------------------------------------------------------------
+// Constant definitions --------------------------------------------------------
+
+#define MODBUS_CRC_INITIAL_VALUE		0xFFFF
+#define MODBUS_MIN_FRAME_SIZE			4		// Address, function and CRC
+
+// CRC16 (polynomial 0xA001, reflected) of every byte value
+static const uint16 modbusCrcTable[256] PROGMEM = {
+	0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+	0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+	0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+	0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+	0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+	0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+	0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+	0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+	0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+	0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+	0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+	0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+	0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+	0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+	0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+	0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+	0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+	0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+	0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+	0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+	0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+	0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+	0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+	0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+	0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+	0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+	0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+	0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+	0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+	0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+	0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+	0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
+};
+
+// -----------------------------------------------------------------------------
+// Global variables ------------------------------------------------------------
+
+static uint8 modbusSlaveAddress = 1;
+static const modbusSlaveCallbacks_t * modbusSlaveCallbacks = NULL;
+static uint8 modbusSlaveFrame[MODBUS_FRAME_SIZE];
+static uint16 modbusSlaveRegisters[MODBUS_MAX_REGISTERS];
+static volatile uint16 modbusSlaveFrameSize = 0;
+static volatile uint16 modbusSlaveFrameCrc = MODBUS_CRC_INITIAL_VALUE;
+static volatile bool_t modbusSlaveFrameOverflow = FALSE;
+static volatile bool_t modbusSlaveFrameReady = FALSE;
+static uint8 modbusSlaveSilencePeriods = 1;		// Compare matches that make up the silence
+static volatile uint8 modbusSlaveSilenceCount = 1;
+
+// -----------------------------------------------------------------------------
+// Private functions declaration -----------------------------------------------
+
+static void modbusSlaveReceive(uint8 data);
+static uint8 modbusSlaveExecute(uint8 size);
+
+// -----------------------------------------------------------------------------
+// Public function definitions -------------------------------------------------
+
+/* -----------------------------------------------------------------------------
+ * Function:	modbusSlaveInit
+ * Purpose:		Configures timer2 to detect the 3.5 characters silence and
+ * 				starts receiving frames addressed to this node
+ * Arguments:	address			slave address (1 to 247)
+ * 				baudRate		baud rate the USART is configured with
+ * 				callbacks		register map callbacks
+ * Returns:		RESULT_OK, RESULT_UNSUPPORTED_VALUE for an invalid address or
+ * 				RESULT_UNSUPPORTED_USART_BAUD_RATE if the silence time cannot
+ * 				be measured by timer2
+ * Notes:		Silences longer than 256 ticks of the largest prescaler (e.g.
+ * 				1200 bps at 16 MHz) are counted over several compare matches
+ * -------------------------------------------------------------------------- */
+
+resultValue_t modbusSlaveInit(uint8 address, uint32 baudRate, const modbusSlaveCallbacks_t * callbacks)
+{
+	static const uint16 prescalers[7] = {1, 8, 32, 64, 128, 256, 1024};
+	uint32 silence;
+	uint32 ticks = 0;
+	uint32 periods = 1;
+	uint8 i;
+
+	if((baudRate == 0) || (address == MODBUS_BROADCAST_ADDRESS) || (address > MODBUS_MAX_SLAVE_ADDRESS))
+		return RESULT_UNSUPPORTED_VALUE;
+
+	// 3.5 characters of 11 bits, fixed at 1750 us above 19200 bps
+	silence = (baudRate > 19200) ? 1750UL : (38500000UL / baudRate);
+	silence = ((F_CPU / 1000UL) * silence) / 1000UL;		// CPU cycles
+	for(i = 0;i < 7;i++) {
+		ticks = (silence + prescalers[i] - 1) / prescalers[i];
+		if(ticks <= 256)
+			break;
+	}
+	if(i == 7) {					// Splits the silence in several compare periods
+		i = 6;
+		periods = (ticks + 255) / 256;
+		ticks = (ticks + periods - 1) / periods;
+	}
+	if((periods > 255) || (ticks == 0))
+		return RESULT_UNSUPPORTED_USART_BAUD_RATE;
+
+	usartSetReceptionCallback(NULL);
+	modbusSlaveAddress = address;
+	modbusSlaveCallbacks = callbacks;
+	modbusSlaveFrameSize = 0;
+	modbusSlaveFrameCrc = MODBUS_CRC_INITIAL_VALUE;
+	modbusSlaveFrameOverflow = FALSE;
+	modbusSlaveFrameReady = FALSE;
+	modbusSlaveSilencePeriods = (uint8)periods;
+
+	timer2DeactivateCompareAInterrupt();
+	timer2SetCompareAValue((uint8)(ticks - 1));
+	timer2Config(TIMER2_MODE_CTC, (timer2PrescalerValue_t)(TIMER2_PRESCALER_OFF + i));
+	usartSetReceptionCallback(modbusSlaveReceive);
+
+	return RESULT_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	modbusSlaveProcess
+ * Purpose:		Executes the last received request, if any, and queues the
+ * 				response in the USART transmission buffer. Must be called
+ * 				periodically by the main loop
+ * Arguments:	none
+ * Returns:		TRUE if a request was processed
+ * -------------------------------------------------------------------------- */
+
+bool_t modbusSlaveProcess(void)
+{
+	uint8 size;
+	uint8 address;
+	uint16 crc;
+	uint16 sent = 0;
+
+	if(!modbusSlaveFrameReady)
+		return FALSE;
+
+	address = modbusSlaveFrame[0];
+	if((address == modbusSlaveAddress) || (address == MODBUS_BROADCAST_ADDRESS)) {
+		size = modbusSlaveExecute((uint8)modbusSlaveFrameSize - 2);
+		if((size > 0) && (address != MODBUS_BROADCAST_ADDRESS)) {	// Broadcasts are not answered
+			crc = modbusSlaveCrc(modbusSlaveFrame, size);
+			modbusSlaveFrame[size++] = (uint8)crc;					// CRC is sent LSB first
+			modbusSlaveFrame[size++] = (uint8)(crc >> 8);
+			while(sent < size) {
+				sent += usartWrite(modbusSlaveFrame + sent, size - sent);
+			}
+		}
+	}
+
+	modbusSlaveFrameSize = 0;
+	modbusSlaveFrameCrc = MODBUS_CRC_INITIAL_VALUE;
+	modbusSlaveFrameReady = FALSE;
+
+	return TRUE;
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	modbusSlaveCrc
+ * Purpose:		Computes the Modbus CRC16 of a block of data
+ * Arguments:	data			pointer to the data
+ * 				size			number of bytes
+ * Returns:		CRC16 value
+ * -------------------------------------------------------------------------- */
+
+uint16 modbusSlaveCrc(const uint8 * data, uint16 size)
+{
+	uint16 crc = MODBUS_CRC_INITIAL_VALUE;
+
+	while(size--) {
+		crc = (crc >> 8) ^ pgm_read_word(&modbusCrcTable[(uint8)crc ^ *data++]);
+	}
+
+	return crc;
+}
+
+// -----------------------------------------------------------------------------
+// Private function definitions ------------------------------------------------
+
+/* -----------------------------------------------------------------------------
+ * Function:	modbusSlaveReceive
+ * Purpose:		Stores a received byte, updates the CRC and restarts the
+ * 				silence timer. Called by the USART_RX_vect handler. Bytes
+ * 				received while the last request is being processed are ignored
+ * Arguments:	data			received byte
+ * Returns:		none
+ * -------------------------------------------------------------------------- */
+
+static void modbusSlaveReceive(uint8 data)
+{
+	uint16 size = modbusSlaveFrameSize;
+	uint16 crc = modbusSlaveFrameCrc;
+
+	if(modbusSlaveFrameReady)
+		return;
+
+	if(size < MODBUS_FRAME_SIZE) {
+		modbusSlaveFrame[size] = data;
+		modbusSlaveFrameSize = size + 1;
+	} else {
+		modbusSlaveFrameOverflow = TRUE;
+	}
+	modbusSlaveFrameCrc = (crc >> 8) ^ pgm_read_word(&modbusCrcTable[(uint8)crc ^ data]);
+
+	modbusSlaveSilenceCount = modbusSlaveSilencePeriods;
+	TCNT2 = 0;
+	TIFR2 = (1 << OCF2A);
+	setBit(TIMSK2, OCIE2A);
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	modbusSlaveExecute
+ * Purpose:		Executes the request in the frame buffer and writes the
+ * 				response (without CRC) in its place
+ * Arguments:	size			size of the request, without CRC
+ * Returns:		size of the response, without CRC
+ * -------------------------------------------------------------------------- */
+
+static uint8 modbusSlaveExecute(uint8 size)
+{
+	uint8 * frame = modbusSlaveFrame;
+	modbusException_t exception = MODBUS_EXCEPTION_NONE;
+	modbusSlaveReadCallback_t readCallback = NULL;
+	uint16 address = ((uint16)frame[2] << 8) | frame[3];
+	uint16 count = ((uint16)frame[4] << 8) | frame[5];
+	uint8 i;
+
+	switch(frame[1]) {
+	case 3:		// Read holding registers
+	case 4:		// Read input registers
+		if(modbusSlaveCallbacks != NULL) {
+			readCallback = (frame[1] == 3) ? modbusSlaveCallbacks->readHoldingRegisters : modbusSlaveCallbacks->readInputRegisters;
+		}
+		if(readCallback == NULL) {
+			exception = MODBUS_EXCEPTION_ILLEGAL_FUNCTION;
+		} else if((size != 6) || (count == 0) || (count > MODBUS_MAX_REGISTERS)) {
+			exception = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+		} else {
+			exception = readCallback(address, count, modbusSlaveRegisters);
+		}
+		if(exception != MODBUS_EXCEPTION_NONE)
+			break;
+		frame[2] = (uint8)(count * 2);
+		for(i = 0;i < count;i++) {
+			frame[3 + (2 * i)] = (uint8)(modbusSlaveRegisters[i] >> 8);
+			frame[4 + (2 * i)] = (uint8)modbusSlaveRegisters[i];
+		}
+		return 3 + (uint8)(count * 2);
+	case 6:		// Write single register
+		if((modbusSlaveCallbacks == NULL) || (modbusSlaveCallbacks->writeHoldingRegisters == NULL)) {
+			exception = MODBUS_EXCEPTION_ILLEGAL_FUNCTION;
+		} else if(size != 6) {
+			exception = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+		} else {
+			modbusSlaveRegisters[0] = count;		// Register value
+			exception = modbusSlaveCallbacks->writeHoldingRegisters(address, 1, modbusSlaveRegisters);
+		}
+		if(exception != MODBUS_EXCEPTION_NONE)
+			break;
+		return 6;									// Echoes the request
+	case 16:	// Write multiple registers
+		if((modbusSlaveCallbacks == NULL) || (modbusSlaveCallbacks->writeHoldingRegisters == NULL)) {
+			exception = MODBUS_EXCEPTION_ILLEGAL_FUNCTION;
+		} else if((size < 7) || (count == 0) || (count > MODBUS_MAX_REGISTERS) || (frame[6] != (count * 2)) || (size != (7 + frame[6]))) {
+			exception = MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE;
+		} else {
+			for(i = 0;i < count;i++) {
+				modbusSlaveRegisters[i] = ((uint16)frame[7 + (2 * i)] << 8) | frame[8 + (2 * i)];
+			}
+			exception = modbusSlaveCallbacks->writeHoldingRegisters(address, count, modbusSlaveRegisters);
+		}
+		if(exception != MODBUS_EXCEPTION_NONE)
+			break;
+		return 6;									// Address, function, start and count
+	default:
+		exception = MODBUS_EXCEPTION_ILLEGAL_FUNCTION;
+		break;
+	}
+
+	frame[1] |= 0x80;
+	frame[2] = exception;
+	return 3;
+}
+
+// -----------------------------------------------------------------------------
+// Interruption handlers -------------------------------------------------------
+
+/* -----------------------------------------------------------------------------
+ * Handler:		TIMER2_COMPA_vect
+ * Purpose:		Ends the frame after 3.5 characters of silence. The frame is
+ *				handed to modbusSlaveProcess() if its CRC is valid (the CRC of
+ *				a frame including its own CRC is zero)
+ * -------------------------------------------------------------------------- */
+
+ISR(TIMER2_COMPA_vect)
+{
+	if(--modbusSlaveSilenceCount != 0)
+		return;
+	clrBit(TIMSK2, OCIE2A);
+	if(!modbusSlaveFrameOverflow && (modbusSlaveFrameSize >= MODBUS_MIN_FRAME_SIZE) && (modbusSlaveFrameCrc == 0)) {
+		modbusSlaveFrameReady = TRUE;
+		return;
+	}
+	modbusSlaveFrameSize = 0;
+	modbusSlaveFrameCrc = MODBUS_CRC_INITIAL_VALUE;
+	modbusSlaveFrameOverflow = FALSE;
+}
@@ -0,0 +1,74 @@
+/* -----------------------------------------------------------------------------
+ * Project:			GPDSE AVR8 Library
+ * File:			modbusSlave.h
+ * Module:			Modbus RTU slave
+ * Author:			Leandro Schwarz
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			Modbus RTU slave engine over the buffered USART. Bytes are
+ *					collected and the CRC16 is updated by the USART_RX_vect
+ *					handler; the end of the frame (3.5 characters of silence)
+ *					is detected by the timer2 compare A interrupt. Supports the
+ *					function codes 3, 4, 6 and 16 through callbacks
+ * Notes:			Requires USART_BUFFERED_MODE. The application configures
+ *					the USART (usartConfig(), usartBufferedInit() and, if
+ *					needed, usartRs485Config()) before calling
+ *					modbusSlaveInit(), and calls modbusSlaveProcess() from the
+ *					main loop. The module owns the TIMER2_COMPA_vect handler.
+ * -------------------------------------------------------------------------- */
+
+#ifndef __MODBUS_SLAVE_H
+#define __MODBUS_SLAVE_H 1
+
+// -----------------------------------------------------------------------------
+// Header files ----------------------------------------------------------------
+
+#include "globalDefines.h"
+#if __GLOBALDEFINES_H != 1
+	#error Error 100 - globalDefines.h - wrong build (globalDefines must be build 1).
+#endif
+
+// -----------------------------------------------------------------------------
+// Constant definitions --------------------------------------------------------
+
+// Frame buffer size (256 holds any Modbus RTU frame). Limits the number of
+// registers read or written by a single request.
+#ifndef MODBUS_FRAME_SIZE
+	#define MODBUS_FRAME_SIZE			64
+#endif
+#define MODBUS_MAX_REGISTERS			((MODBUS_FRAME_SIZE - 9) / 2)
+#define MODBUS_BROADCAST_ADDRESS		0x00
+#define MODBUS_MAX_SLAVE_ADDRESS		247
+
+// -----------------------------------------------------------------------------
+// New data types --------------------------------------------------------------
+
+typedef enum modbusException_t {
+	MODBUS_EXCEPTION_NONE = 0,
+	MODBUS_EXCEPTION_ILLEGAL_FUNCTION = 1,
+	MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS = 2,
+	MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE = 3,
+	MODBUS_EXCEPTION_SLAVE_DEVICE_FAILURE = 4
+} modbusException_t;
+
+// Reads count registers starting at address into values
+typedef modbusException_t (* modbusSlaveReadCallback_t)(uint16 address, uint16 count, uint16 * values);
+// Writes count registers starting at address from values
+typedef modbusException_t (* modbusSlaveWriteCallback_t)(uint16 address, uint16 count, const uint16 * values);
+
+// Register map; a NULL entry answers its function codes with an illegal
+// function exception
+typedef struct modbusSlaveCallbacks_t {
+	modbusSlaveReadCallback_t readHoldingRegisters;		// Function code 3
+	modbusSlaveReadCallback_t readInputRegisters;		// Function code 4
+	modbusSlaveWriteCallback_t writeHoldingRegisters;	// Function codes 6 and 16
+} modbusSlaveCallbacks_t;
+
+// -----------------------------------------------------------------------------
+// Function declarations -------------------------------------------------------
+
+resultValue_t	modbusSlaveInit(uint8 address, uint32 baudRate, const modbusSlaveCallbacks_t * callbacks);
+bool_t			modbusSlaveProcess(void);
+uint16			modbusSlaveCrc(const uint8 * data, uint16 size);
+
+#endif
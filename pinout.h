@@ -114,11 +114,21 @@
 	#define SPI_MOSI	PB3
 	#define SPI_SCLK	PB5
 	#define SPI_SS		PB2
+	#define TIMER1_ICP_DDR	DDRB
+	#define TIMER1_ICP_PORT	PORTB
+	#define TIMER1_ICP_PIN	PINB
+	#define TIMER1_ICP		PB0
 	#define TWI_DDR		DDRC
 	#define TWI_PORT	PORTC
 	#define TWI_PIN		PINC
 	#define TWI_SDA		PC4
 	#define TWI_SCL		PC5
+	#define USART_DDR	DDRD
+	#define USART_PORT	PORTD
+	#define USART_PIN	PIND
+	#define USART_RXD	PD0
+	#define USART_TXD	PD1
+	#define USART_XCK	PD4
 #elif defined (__AVR_ATmega329__)
 #elif defined (__AVR_ATmega329A__)
 #elif defined (__AVR_ATmega329P__)
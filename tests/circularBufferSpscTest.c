@@ -0,0 +1,158 @@
+/* -----------------------------------------------------------------------------
+ * Project:			GPDSE AVR8 Library
+ * File:			tests/circularBufferSpscTest.c
+ * Module:			Host stress test of the SPSC circular buffer
+ * Author:			Leandro Schwarz
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			Two threads stand in for the ISR (producer) and the main
+ *					loop (consumer), sharing a buffer without any lock. The
+ *					consumer checks that every element arrives once, in order
+ *					and untorn. Both the malloc() based and the static buffers
+ *					are exercised. The only ordering used by the module is a
+ *					compiler barrier, which matches AVR and x86 (TSO) hosts
+ * -------------------------------------------------------------------------- */
+
+// -----------------------------------------------------------------------------
+// Header files ----------------------------------------------------------------
+
+#include "circularBuffer.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+// -----------------------------------------------------------------------------
+// Constant definitions --------------------------------------------------------
+
+#define SPSC_TEST_ELEMENTS			1000000UL
+#define SPSC_TEST_LENGTH			16
+
+// -----------------------------------------------------------------------------
+// Global variables ------------------------------------------------------------
+
+static createCircularBufferSpsc(spscBuffer);
+createStaticCircularBufferSpsc(spscStatic, uint32, SPSC_TEST_LENGTH)
+
+// -----------------------------------------------------------------------------
+// Private function definitions ------------------------------------------------
+
+// Each element carries the sequence number on its four bytes, so a torn copy
+// is detected as a mismatch
+static uint32 spscTestPattern(uint32 sequence)
+{
+	return (sequence & 0x00FFFFFFUL) | ((sequence * 0x9EUL) << 24);
+}
+
+static void * spscTestProducer(void * argument)
+{
+	uint32 i;
+	uint32 value;
+
+	for(i = 0;i < SPSC_TEST_ELEMENTS;i++) {
+		value = spscTestPattern(i);
+		if(argument == NULL) {
+			while(!circularBufferSpscPushData(&spscBuffer, &value))
+				sched_yield();
+		} else {
+			while(!spscStaticPush(value))
+				sched_yield();
+		}
+	}
+
+	return NULL;
+}
+
+static uint32 spscTestConsumer(bool_t staticBuffer)
+{
+	uint32 i;
+	uint32 value;
+	uint32 errors = 0;
+	uint8 occupation;
+
+	for(i = 0;i < SPSC_TEST_ELEMENTS;i++) {
+		if(!staticBuffer) {
+			occupation = circularBufferSpscGetOccupation(&spscBuffer);
+			if(occupation > SPSC_TEST_LENGTH)
+				errors++;
+			while(!circularBufferSpscPopData(&spscBuffer, &value))
+				sched_yield();
+		} else {
+			while(!spscStaticPop(&value))
+				sched_yield();
+		}
+		if(value != spscTestPattern(i)) {
+			if(errors == 0)
+				printf("  element %lu: expected 0x%08lX, got 0x%08lX\n", (unsigned long)i, (unsigned long)spscTestPattern(i), (unsigned long)value);
+			errors++;
+		}
+	}
+
+	return errors;
+}
+
+static uint32 spscTestRun(bool_t staticBuffer)
+{
+	pthread_t producer;
+	uint32 errors;
+
+	if(pthread_create(&producer, NULL, spscTestProducer, staticBuffer ? (void *)&spscStatic : NULL) != 0) {
+		printf("  cannot create producer thread\n");
+		return 1;
+	}
+	errors = spscTestConsumer(staticBuffer);
+	pthread_join(producer, NULL);
+	if(staticBuffer ? !spscStaticPop(&(uint32){0}) : circularBufferSpscIsEmpty(&spscBuffer))
+		return errors;
+
+	return errors + 1;
+}
+
+static uint32 spscTestInit(void)
+{
+	circularBufferSpsc_t buffer;
+	uint32 errors = 0;
+	uint32 value = 0;
+	uint16 i;
+
+	errors += circularBufferSpscInit(&buffer, 0, 1) != FALSE;
+	errors += circularBufferSpscInit(&buffer, 12, 1) != FALSE;
+	errors += circularBufferSpscInit(&buffer, 256, 1) != FALSE;
+	errors += circularBufferSpscInit(&buffer, 8, 0) != FALSE;
+	errors += circularBufferSpscInit(&buffer, 128, 4) != TRUE;
+
+	for(i = 0;i < 128;i++)
+		errors += circularBufferSpscPushData(&buffer, &value) != TRUE;
+	errors += circularBufferSpscIsFull(&buffer) != TRUE;
+	errors += circularBufferSpscPushData(&buffer, &value) != FALSE;
+	errors += circularBufferSpscGetOccupation(&buffer) != 128;
+	free(buffer.data);
+
+	return errors;
+}
+
+// -----------------------------------------------------------------------------
+// Main function ---------------------------------------------------------------
+
+int main(void)
+{
+	uint32 errors;
+	uint32 total = 0;
+
+	errors = spscTestInit();
+	printf("init/capacity checks: %s\n", errors ? "FAIL" : "ok");
+	total += errors;
+
+	if(!circularBufferSpscInit(&spscBuffer, SPSC_TEST_LENGTH, sizeof(uint32))) {
+		printf("circularBufferSpscInit failed\n");
+		return 1;
+	}
+	errors = spscTestRun(FALSE);
+	printf("threaded circularBufferSpscPushData/PopData, %lu elements: %s\n", SPSC_TEST_ELEMENTS, errors ? "FAIL" : "ok");
+	total += errors;
+
+	errors = spscTestRun(TRUE);
+	printf("threaded createStaticCircularBufferSpsc Push/Pop, %lu elements: %s\n", SPSC_TEST_ELEMENTS, errors ? "FAIL" : "ok");
+	total += errors;
+
+	return (total == 0) ? 0 : 1;
+}
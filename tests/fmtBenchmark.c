@@ -0,0 +1,105 @@
+/* -----------------------------------------------------------------------------
+ * Project:			GPDSE AVR8 Library
+ * File:			tests/fmtBenchmark.c
+ * Module:			Host benchmark of the formatting module
+ * Author:			Leandro Schwarz
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			Measures the average cost of each fmt function against the
+ *					equivalent snprintf() conversion. Counts are host cycles
+ *					(time stamp counter on x86, nanoseconds elsewhere). A host
+ *					with a hardware divider favors snprintf(), so the figures
+ *					are a regression reference for the fmt code, not an
+ *					estimate of the AVR cost, where vfprintf() also pays for
+ *					the software 32-bit division
+ * -------------------------------------------------------------------------- */
+
+// -----------------------------------------------------------------------------
+// Header files ----------------------------------------------------------------
+
+#include "fmt.h"
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+	#define fmtBenchmarkNow()			((uint64)__rdtsc())
+	#define FMT_BENCHMARK_UNIT			"cycles"
+#else
+	#define fmtBenchmarkNow()			fmtBenchmarkNanoseconds()
+	#define FMT_BENCHMARK_UNIT			"ns"
+#endif
+
+// -----------------------------------------------------------------------------
+// Constant definitions --------------------------------------------------------
+
+#define FMT_BENCHMARK_VALUES		1024
+#define FMT_BENCHMARK_ROUNDS		200
+
+// -----------------------------------------------------------------------------
+// Global variables ------------------------------------------------------------
+
+static uint32 fmtBenchmarkValues[FMT_BENCHMARK_VALUES];
+static volatile uint8 fmtBenchmarkSink;
+
+// -----------------------------------------------------------------------------
+// Macrofunctions --------------------------------------------------------------
+
+// Runs statement over every value and prints the average cost per conversion
+#define fmtBenchmarkRun(name, statement)	do{										\
+		char string[24];															\
+		uint64 start = fmtBenchmarkNow();											\
+		uint32 round;																\
+		uint16 i;																	\
+		for(round = 0;round < FMT_BENCHMARK_ROUNDS;round++){						\
+			for(i = 0;i < FMT_BENCHMARK_VALUES;i++){								\
+				uint32 value = fmtBenchmarkValues[i];								\
+				statement;															\
+				fmtBenchmarkSink ^= string[0];										\
+			}																		\
+		}																			\
+		printf("  %-10s %8.1f " FMT_BENCHMARK_UNIT "\n", (name),					\
+				(double)(fmtBenchmarkNow() - start) / (FMT_BENCHMARK_ROUNDS * FMT_BENCHMARK_VALUES));	\
+	}while(0)
+
+// -----------------------------------------------------------------------------
+// Private function definitions ------------------------------------------------
+
+#if !defined(__x86_64__) && !defined(__i386__)
+static uint64 fmtBenchmarkNanoseconds(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64)now.tv_sec * 1000000000ULL + (uint64)now.tv_nsec;
+}
+#endif
+
+// -----------------------------------------------------------------------------
+// Main function ---------------------------------------------------------------
+
+int main(void)
+{
+	uint32 seed = 0x2545F491UL;
+	uint16 i;
+
+	for(i = 0;i < FMT_BENCHMARK_VALUES;i++) {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		fmtBenchmarkValues[i] = seed >> (seed & 0x1F);	// Mixed magnitudes
+	}
+
+	printf("fmtU16 / \"%%u\"\n");
+	fmtBenchmarkRun("fmt", fmtU16(string, (uint16)value));
+	fmtBenchmarkRun("snprintf", snprintf(string, sizeof(string), "%u", (unsigned)(uint16)value));
+	printf("fmtI32 / \"%%ld\"\n");
+	fmtBenchmarkRun("fmt", fmtI32(string, (int32)value));
+	fmtBenchmarkRun("snprintf", snprintf(string, sizeof(string), "%ld", (long)(int32)value));
+	printf("fmtHex16 / \"%%04X\"\n");
+	fmtBenchmarkRun("fmt", fmtHex16(string, (uint16)value));
+	fmtBenchmarkRun("snprintf", snprintf(string, sizeof(string), "%04X", (unsigned)(uint16)value));
+	printf("fmtFixed(q, 8, 2) / \"%%.2f\"\n");
+	fmtBenchmarkRun("fmt", fmtFixed(string, (int32)value, 8, 2));
+	fmtBenchmarkRun("snprintf", snprintf(string, sizeof(string), "%.2f", (int32)value / 256.0));
+
+	return 0;
+}
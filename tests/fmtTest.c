@@ -0,0 +1,160 @@
+/* -----------------------------------------------------------------------------
+ * Project:			GPDSE AVR8 Library
+ * File:			tests/fmtTest.c
+ * Module:			Host test of the formatting module
+ * Author:			Leandro Schwarz
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			Compares the output of the fmt functions with snprintf() for
+ *					edge values (zero, minimum, maximum, powers of ten, rounding
+ *					carry) and for a deterministic pseudo-random sweep
+ * -------------------------------------------------------------------------- */
+
+// -----------------------------------------------------------------------------
+// Header files ----------------------------------------------------------------
+
+#include "fmt.h"
+#include <math.h>
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+// Constant definitions --------------------------------------------------------
+
+#define FMT_TEST_RANDOM_VALUES		200000UL
+
+// -----------------------------------------------------------------------------
+// Global variables ------------------------------------------------------------
+
+static uint32 fmtTestErrors = 0;
+static uint32 fmtTestChecks = 0;
+static uint32 fmtTestSeed = 0x2545F491UL;
+
+static const uint32 fmtTestEdges32[] = {
+	0UL, 1UL, 9UL, 10UL, 99UL, 100UL, 999UL, 1000UL, 9999UL, 10000UL, 65535UL,
+	65536UL, 99999UL, 100000UL, 999999UL, 1000000UL, 9999999UL, 10000000UL,
+	99999999UL, 100000000UL, 999999999UL, 1000000000UL, 2147483647UL,
+	2147483648UL, 4294967295UL
+};
+
+// -----------------------------------------------------------------------------
+// Private function definitions ------------------------------------------------
+
+static uint32 fmtTestRandom(void)
+{
+	fmtTestSeed ^= fmtTestSeed << 13;
+	fmtTestSeed ^= fmtTestSeed >> 17;
+	fmtTestSeed ^= fmtTestSeed << 5;
+	return fmtTestSeed;
+}
+
+static void fmtTestCompare(const char * function, const char * result, const char * end, const char * expected)
+{
+	fmtTestChecks++;
+	if((strcmp(result, expected) != 0) || (end != result + strlen(result))) {
+		if(fmtTestErrors < 20)
+			printf("  %s: got \"%s\", expected \"%s\"\n", function, result, expected);
+		fmtTestErrors++;
+	}
+}
+
+static void fmtTestIntegers(uint32 value)
+{
+	char result[24];
+	char expected[24];
+	char * end;
+
+	end = fmtU16(result, (uint16)value);
+	snprintf(expected, sizeof(expected), "%u", (unsigned)(uint16)value);
+	fmtTestCompare("fmtU16", result, end, expected);
+
+	end = fmtI16(result, (int16)value);
+	snprintf(expected, sizeof(expected), "%d", (int)(int16)value);
+	fmtTestCompare("fmtI16", result, end, expected);
+
+	end = fmtU32(result, value);
+	snprintf(expected, sizeof(expected), "%lu", (unsigned long)value);
+	fmtTestCompare("fmtU32", result, end, expected);
+
+	end = fmtI32(result, (int32)value);
+	snprintf(expected, sizeof(expected), "%ld", (long)(int32)value);
+	fmtTestCompare("fmtI32", result, end, expected);
+
+	end = fmtHex8(result, (uint8)value);
+	snprintf(expected, sizeof(expected), "%02X", (unsigned)(uint8)value);
+	fmtTestCompare("fmtHex8", result, end, expected);
+
+	end = fmtHex16(result, (uint16)value);
+	snprintf(expected, sizeof(expected), "%04X", (unsigned)(uint16)value);
+	fmtTestCompare("fmtHex16", result, end, expected);
+}
+
+// fmtFixed() rounds half away from zero and never prints "-0". The value of q
+// and its scaled value are exact in a double, so round() gives the reference
+static void fmtTestFixed(int32 q, uint8 fracBits, uint8 digits)
+{
+	char result[24];
+	char expected[32];
+	char function[32];
+	char * end;
+	double scale = pow(10, digits);
+	double value = round(ldexp((double)q, -fracBits) * scale);
+
+	if(value == 0)
+		value = 0;							// Drops the sign of -0.0
+	snprintf(expected, sizeof(expected), "%.*f", digits, value / scale);
+	end = fmtFixed(result, q, fracBits, digits);
+	snprintf(function, sizeof(function), "fmtFixed(%ld, %u, %u)", (long)q, fracBits, digits);
+	fmtTestCompare(function, result, end, expected);
+}
+
+static void fmtTestFixedValue(int32 q)
+{
+	uint8 fracBits;
+	uint8 digits;
+
+	for(fracBits = 0;fracBits <= FMT_MAX_FRACTION_BITS;fracBits++)
+		for(digits = 0;digits <= FMT_MAX_FRACTION_DIGITS;digits++)
+			fmtTestFixed(q, fracBits, digits);
+}
+
+// -----------------------------------------------------------------------------
+// Main function ---------------------------------------------------------------
+
+int main(void)
+{
+	uint32 i;
+	uint32 value;
+
+	for(i = 0;i < sizeof(fmtTestEdges32) / sizeof(fmtTestEdges32[0]);i++) {
+		value = fmtTestEdges32[i];
+		fmtTestIntegers(value);
+		fmtTestIntegers(value - 1);
+		fmtTestIntegers((uint32)0 - value);
+		fmtTestIntegers(value & 0xFFFF);
+		fmtTestIntegers((value & 0xFFFF) | 0x8000);
+		fmtTestFixedValue((int32)value);
+		fmtTestFixedValue((int32)((uint32)0 - value));
+	}
+	// Rounding carry into the integer part (x.99995 and -x.99995)
+	for(i = 0;i < 4;i++) {
+		fmtTestFixedValue((int32)(((i + 1) << 16) - 3));
+		fmtTestFixedValue(-(int32)(((i + 1) << 16) - 3));
+		fmtTestFixedValue((int32)(((i + 1) << 8) - 1));
+	}
+	// Exact ties (x.5, x.05, x.005, ...)
+	fmtTestFixedValue(0x00018000L);
+	fmtTestFixedValue(-0x00018000L);
+	fmtTestFixedValue(0x00000CCDL);
+	fmtTestFixedValue(5);
+
+	for(i = 0;i < FMT_TEST_RANDOM_VALUES;i++) {
+		value = fmtTestRandom();
+		fmtTestIntegers(value);
+		fmtTestIntegers(value >> (value & 0x1F));
+		fmtTestFixed((int32)value, value % (FMT_MAX_FRACTION_BITS + 1), (value >> 8) % (FMT_MAX_FRACTION_DIGITS + 1));
+	}
+
+	printf("%lu comparisons against snprintf(): %s\n", (unsigned long)fmtTestChecks, fmtTestErrors ? "FAIL" : "ok");
+
+	return (fmtTestErrors == 0) ? 0 : 1;
+}
@@ -0,0 +1,21 @@
+/* -----------------------------------------------------------------------------
+ * Project:			GPDSE AVR8 Library
+ * File:			tests/stub/avr/interrupt.h
+ * Module:			Host replacement for avr-libc avr/interrupt.h
+ * Author:			Leandro Schwarz
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			Interruption handlers become plain functions that the tests
+ *					call to emulate the hardware events
+ * -------------------------------------------------------------------------- */
+
+#ifndef _AVR_INTERRUPT_H_
+#define _AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define ISR(vector)			void vector(void)
+#define sei()				setBit(SREG, SREG_I)
+#define cli()				clrBit(SREG, SREG_I)
+
+#endif
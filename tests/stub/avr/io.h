@@ -0,0 +1,130 @@
+/* -----------------------------------------------------------------------------
+ * Project:			GPDSE AVR8 Library
+ * File:			tests/stub/avr/io.h
+ * Module:			Host replacement for avr-libc avr/io.h (ATmega328)
+ * Author:			Leandro Schwarz
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			Maps the I/O registers used by the library into the
+ *					avrRegisters[] array (indexed by data memory address), so
+ *					the modules can be compiled and driven on the host. Tests
+ *					define the array and call the interruption handlers as
+ *					plain functions
+ * -------------------------------------------------------------------------- */
+
+#ifndef _AVR_IO_H_
+#define _AVR_IO_H_
+
+#include <stdint.h>
+
+extern volatile uint8_t avrRegisters[256];
+
+#define _R(address)			(avrRegisters[address])
+#define _R16(address)		(*(volatile uint16_t *)&avrRegisters[address])
+
+#define PINB _R(0x23)
+#define DDRB _R(0x24)
+#define PORTB _R(0x25)
+#define PINC _R(0x26)
+#define DDRC _R(0x27)
+#define PORTC _R(0x28)
+#define PIND _R(0x29)
+#define DDRD _R(0x2A)
+#define PORTD _R(0x2B)
+#define TIFR0 _R(0x35)
+#define TIFR1 _R(0x36)
+#define TIFR2 _R(0x37)
+#define PCIFR _R(0x3B)
+#define EIFR _R(0x3C)
+#define EIMSK _R(0x3D)
+#define EECR _R(0x3F)
+#define EEDR _R(0x40)
+#define EEAR _R16(0x41)
+#define TCCR0A _R(0x44)
+#define TCCR0B _R(0x45)
+#define TCNT0 _R(0x46)
+#define OCR0A _R(0x47)
+#define OCR0B _R(0x48)
+#define SPCR _R(0x4C)
+#define SPSR _R(0x4D)
+#define SPDR _R(0x4E)
+#define SPMCSR _R(0x57)
+#define MCUCR _R(0x55)
+#define SREG _R(0x5F)
+#define CLKPR _R(0x61)
+#define PCICR _R(0x68)
+#define EICRA _R(0x69)
+#define PCMSK0 _R(0x6B)
+#define PCMSK1 _R(0x6C)
+#define PCMSK2 _R(0x6D)
+#define TIMSK0 _R(0x6E)
+#define TIMSK1 _R(0x6F)
+#define TIMSK2 _R(0x70)
+#define TCCR1A _R(0x80)
+#define TCCR1B _R(0x81)
+#define TCCR1C _R(0x82)
+#define TCNT1 _R16(0x84)
+#define ICR1 _R16(0x86)
+#define OCR1A _R16(0x88)
+#define OCR1B _R16(0x8A)
+#define TCCR2A _R(0xB0)
+#define TCCR2B _R(0xB1)
+#define TCNT2 _R(0xB2)
+#define OCR2A _R(0xB3)
+#define OCR2B _R(0xB4)
+#define ASSR _R(0xB6)
+#define TWBR _R(0xB8)
+#define TWSR _R(0xB9)
+#define TWAR _R(0xBA)
+#define TWDR _R(0xBB)
+#define TWCR _R(0xBC)
+#define TWAMR _R(0xBD)
+#define UCSR0A _R(0xC0)
+#define UCSR0B _R(0xC1)
+#define UCSR0C _R(0xC2)
+#define UBRR0 _R16(0xC4)
+#define UBRR0L _R(0xC4)
+#define UBRR0H _R(0xC5)
+#define UDR0 _R(0xC6)
+#define ADCSRA _R(0x7A)
+enum { PB0,PB1,PB2,PB3,PB4,PB5,PB6,PB7 };
+enum { PC0,PC1,PC2,PC3,PC4,PC5,PC6 };
+enum { PD0,PD1,PD2,PD3,PD4,PD5,PD6,PD7 };
+enum { MPCM0=0,U2X0,UPE0,DOR0,FE0,UDRE0,TXC0,RXC0 };
+enum { TXB80=0,RXB80,UCSZ02,TXEN0,RXEN0,UDRIE0,TXCIE0,RXCIE0 };
+enum { UCPOL0=0,UCSZ00=1,UCPHA0=1,UCSZ01=2,UDORD0=2,USBS0=3,UPM00=4,UPM01=5,UMSEL00=6,UMSEL01=7 };
+enum { TWIE=0,TWEN=2,TWWC=3,TWSTO=4,TWSTA=5,TWEA=6,TWINT=7 };
+enum { TWPS0=0,TWPS1=1 };
+enum { TOIE0=0,OCIE0A,OCIE0B };
+enum { TOV0=0,OCF0A,OCF0B };
+enum { TOIE1=0,OCIE1A,OCIE1B,ICIE1=5 };
+enum { TOV1=0,OCF1A,OCF1B,ICF1=5 };
+enum { TOIE2=0,OCIE2A,OCIE2B };
+enum { TOV2=0,OCF2A,OCF2B };
+enum { WGM00=0,WGM01=1,COM0B0=4,COM0A0=6 };
+enum { CS00=0,CS01,CS02,WGM02 };
+enum { WGM10=0,WGM11=1,COM1B0=4,COM1A0=6 };
+enum { CS10=0,CS11,CS12,WGM12,WGM13,ICES1=6,ICNC1=7 };
+enum { FOC1B=6,FOC1A=7 };
+enum { WGM20=0,WGM21=1,COM2B0=4,COM2A0=6 };
+enum { CS20=0,CS21,CS22,WGM22,FOC2B=6,FOC2A=7 };
+enum { SPR0=0,SPR1,CPHA,CPOL,MSTR,DORD,SPE,SPIE };
+enum { SPI2X=0, SPIF=7 };
+enum { PUD=4 };
+enum { PCIE0=0,PCIE1,PCIE2 };
+enum { PCINT0=0,PCINT8=0,PCINT16=0 };
+enum { INT0=0, INT1, INTF0=0, INTF1, ISC00=0, ISC10=2 };
+enum { EERE=0,EEPE,EEMPE,EERIE,EEPM0 };
+enum { SPMEN=0 };
+enum { SREG_I=7 };
+#define _BV(bit) (1 << (bit))
+#define __builtin_avr_delay_cycles(cycles) ((void)(cycles))
+
+// avr-libc stdio extensions
+#define FDEV_SETUP_STREAM(put, get, flags) {0}
+#define _FDEV_SETUP_WRITE 2
+#define _FDEV_SETUP_RW 3
+#define _FDEV_ERR (-1)
+#define _FDEV_EOF (-2)
+
+#endif
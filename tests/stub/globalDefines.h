@@ -0,0 +1,49 @@
+/* -----------------------------------------------------------------------------
+ * Project:			GPDSE AVR8 Library
+ * File:			tests/stub/globalDefines.h
+ * Module:			Host replacement for globalDefines.h
+ * Author:			Leandro Schwarz
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			Provides the data types and macros of globalDefines.h
+ *					without the AVR headers, so hardware-independent modules can
+ *					be compiled on the host. It is force-included by the tests
+ *					Makefile, which makes the guard skip the real globalDefines.h
+ * -------------------------------------------------------------------------- */
+
+#ifndef __GLOBALDEFINES_H
+#define __GLOBALDEFINES_H 1
+
+#include <stdio.h>
+#include <stdint.h>
+
+
+#define setBit(reg, bit)					((reg) |= (1 << (bit)))
+#define clrBit(reg, bit)					((reg) &= ~(1 << (bit)))
+#define cplBit(reg, bit)					((reg) ^= (1 << (bit)))
+#define isBitSet(reg, bit)					(((reg) >> (bit)) & 1)
+#define isBitClr(reg, bit)					(!(((reg) >> (bit)) & 1))
+
+typedef int8_t				int8;
+typedef int16_t				int16;
+typedef int32_t				int32;
+typedef int64_t				int64;
+typedef uint8_t				uint8;
+typedef uint16_t			uint16;
+typedef uint32_t			uint32;
+typedef uint64_t			uint64;
+typedef volatile int8_t		vint8;
+typedef volatile int16_t	vint16;
+typedef volatile int32_t	vint32;
+typedef volatile int64_t	vint64;
+typedef volatile uint8_t	vuint8;
+typedef volatile uint16_t	vuint16;
+typedef volatile uint32_t	vuint32;
+typedef volatile uint64_t	vuint64;
+
+typedef enum bool_t {
+	FALSE = 0,
+	TRUE = 1
+} bool_t;
+
+#endif
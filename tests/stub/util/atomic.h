@@ -0,0 +1,19 @@
+/* -----------------------------------------------------------------------------
+ * Project:			GPDSE AVR8 Library
+ * File:			tests/stub/util/atomic.h
+ * Module:			Host replacement for avr-libc util/atomic.h
+ * Author:			Leandro Schwarz
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			Runs the block once. The host tests never share the buffers
+ *					guarded by ATOMIC_BLOCK between threads
+ * -------------------------------------------------------------------------- */
+
+#ifndef _UTIL_ATOMIC_H_
+#define _UTIL_ATOMIC_H_
+
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+#define ATOMIC_BLOCK(type)					for(int atomicOnce = 1; atomicOnce; atomicOnce = 0)
+
+#endif
@@ -0,0 +1,17 @@
+/* -----------------------------------------------------------------------------
+ * Project:			GPDSE AVR8 Library
+ * File:			tests/stub/util/delay.h
+ * Module:			Host replacement for avr-libc util/delay.h
+ * Author:			Leandro Schwarz
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			Busy-wait delays do nothing on the host
+ * -------------------------------------------------------------------------- */
+
+#ifndef _UTIL_DELAY_H_
+#define _UTIL_DELAY_H_
+
+#define _delay_us(us)		((void)(us))
+#define _delay_ms(ms)		((void)(ms))
+
+#endif
@@ -0,0 +1,102 @@
+/* -----------------------------------------------------------------------------
+ * Project:			GPDSE AVR8 Library
+ * File:			tests/usartTest.c
+ * Module:			Host test of the buffered USART transmitter
+ * Author:			Leandro Schwarz
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			Checks the USART_TX_FULL_TRUNCATE policy of the standard
+ *					output handler. The transmitter is emulated by calling
+ *					USART_UDRE_vect and collecting UDR0
+ * -------------------------------------------------------------------------- */
+
+// -----------------------------------------------------------------------------
+// Header files ----------------------------------------------------------------
+
+#include "usart.h"
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+// Global variables ------------------------------------------------------------
+
+volatile uint8_t avrRegisters[256];
+static uint32 usartTestErrors = 0;
+
+// -----------------------------------------------------------------------------
+// Private functions declaration -----------------------------------------------
+
+void USART_UDRE_vect(void);
+
+// -----------------------------------------------------------------------------
+// Private function definitions ------------------------------------------------
+
+static void usartTestCheck(bool_t condition, const char * description)
+{
+	if(!condition) {
+		printf("  FAIL: %s\n", description);
+		usartTestErrors++;
+	}
+}
+
+static void usartTestPuts(const char * string)
+{
+	while(*string)
+		usartTransmitBufferedStd(*string++, NULL);
+}
+
+// Runs the transmitter until the buffer is empty, storing the bytes sent
+static uint16 usartTestDrain(char * output, uint16 size)
+{
+	uint16 count = 0;
+
+	while(usartGetTxFree() < USART_TX_BUFFER_SIZE) {
+		USART_UDRE_vect();
+		if(count < size - 1)
+			output[count++] = UDR0;
+	}
+	output[count] = '\0';
+
+	return count;
+}
+
+static void usartTestFill(void)
+{
+	while(usartGetTxFree() > 0)
+		usartTransmitBufferedStd('x', NULL);
+}
+
+// -----------------------------------------------------------------------------
+// Main function ---------------------------------------------------------------
+
+int main(void)
+{
+	char output[USART_TX_BUFFER_SIZE + 1];
+
+	usartBufferedInit();
+	usartSetTxFullPolicy(USART_TX_FULL_TRUNCATE);
+
+	// Newline pushed while truncating: the line ends with it
+	usartResetDroppedBytes();
+	usartTestFill();
+	usartTransmitBufferedStd('a', NULL);			// Starts truncating
+	usartTestDrain(output, sizeof(output));
+	usartTestPuts("bc\nok\n");
+	usartTestDrain(output, sizeof(output));
+	usartTestCheck(strcmp(output, "\nok\n") == 0, "rest of the line dropped, newline and next line sent");
+	usartTestCheck(usartGetDroppedBytes() == 3, "dropped bytes counted (a, b, c)");
+
+	// Newline arriving while the buffer is still full
+	usartResetDroppedBytes();
+	usartTestFill();
+	usartTransmitBufferedStd('a', NULL);			// Starts truncating
+	usartTransmitBufferedStd('\n', NULL);			// Lost, but ends the truncation
+	usartTestDrain(output, sizeof(output));
+	usartTestPuts("ok\n");
+	usartTestDrain(output, sizeof(output));
+	usartTestCheck(strcmp(output, "ok\n") == 0, "line after a lost newline is sent");
+	usartTestCheck(usartGetDroppedBytes() == 2, "lost newline counted as dropped");
+
+	printf("USART_TX_FULL_TRUNCATE policy: %s\n", usartTestErrors ? "FAIL" : "ok");
+
+	return (usartTestErrors == 0) ? 0 : 1;
+}
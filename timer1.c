@@ -11,9 +11,10 @@
 // Header files ----------------------------------------------------------------
 
 #include "timer1.h"
-#if __TIMER1_H != 130
-	#error Error 101 - Version mismatch on header and source code files (timer1).
+#if __TIMER1_H != 1
+	#error Error 101 - Build mismatch on header and source code files (timer1).
 #endif
+#include <util/atomic.h>
 
 /* -----------------------------------------------------------------------------
  * Configures the timer1 mode and prescaler
@@ -8,14 +8,14 @@
  * -------------------------------------------------------------------------- */
 
 #ifndef __TIMER1_H
-#define __TIMER1_H 130
+#define __TIMER1_H 1
 
 // -----------------------------------------------------------------------------
 // Header files ----------------------------------------------------------------
 
 #include "globalDefines.h"
-#if __GLOBALDEFINES_H != 130
-	#error Error 100 - globalDefines.h - wrong version (globalDefines must be version 13.0).
+#if __GLOBALDEFINES_H != 1
+	#error Error 100 - globalDefines.h - wrong build (globalDefines must be build 1).
 #endif
 
 // -----------------------------------------------------------------------------
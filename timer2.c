@@ -11,8 +11,8 @@
 // Header files ----------------------------------------------------------------
 
 #include "timer2.h"
-#if __TIMER2_H != 130
-	#error Error 101 - Version mismatch on header and source code files (timer2).
+#if __TIMER2_H != 1
+	#error Error 101 - Build mismatch on header and source code files (timer2).
 #endif
 
 /* -----------------------------------------------------------------------------
@@ -21,14 +21,56 @@
 #if __TWIMASTER_H != 1
 	#error Error 101 - Version mismatch on header and source code files (twiMaster).
 #endif
+#include "circularBuffer.h"
+#if __CIRCULAR_BUFFER_H != 1
+	#error Error 100 - circularBuffer.h - wrong build (circularBuffer must be build 1).
+#endif
+#include <util/atomic.h>
+#include <string.h>
+#ifdef TWI_MASTER_TRACE
+	#include <avr/pgmspace.h>
+	#include "fmt.h"
+	#if __FMT_H != 1
+		#error Error 100 - fmt.h - wrong build (fmt must be build 1).
+	#endif
+	_Static_assert((((TWI_TRACE_SIZE) & ((TWI_TRACE_SIZE) - 1)) == 0) && ((TWI_TRACE_SIZE) > 0) &&
+			((TWI_TRACE_SIZE) <= 128), "TWI_TRACE_SIZE must be a power of two up to 128");
+#endif
 
 // -----------------------------------------------------------------------------
 // Global variables ------------------------------------------------------------
 
-static uint8 twiBufferData[TWI_BUFFER_SIZE];	// Transceiver buffer
-static uint8 twiBufferSize;						// Number of bytes to be transmitted
+static twiMasterJob_t twiSendDataJob;			// Transaction of twiMasterSendData()
 volatile static twiState_t twiState = TWI_NO_STATE;		// twiSatet_t is defined in twiMaster.h
 twiStatus_t twiStatus = {0};				// twiStatus_t is defined in twiMaster.h
+createStaticCircularBufferSpsc(twiJobQueue, twiMasterJob_t *, TWI_JOB_QUEUE_SIZE)
+static twiMasterJob_t * volatile twiCurrentJob = NULL;	// Job being transferred
+static bool_t twiReadPhase = FALSE;				// Current job is in its read part
+static volatile uint8 twiTimeoutCounter = TWI_MASTER_TIMEOUT;
+static volatile bool_t twiRecoveryPending = FALSE;	// Set by a timeout, cleared by twiMasterService()
+static volatile twiMasterBusStatistics_t twiBusStatistics = {0, 0, 0};
+#ifdef TWI_MASTER_TRACE
+static twiMasterTraceEntry_t twiTraceBuffer[TWI_TRACE_SIZE];
+static volatile uint8 twiTraceIndex = 0;			// Free-running write index
+static volatile uint8 twiTraceCount = 0;			// Valid entries
+static volatile bool_t twiTraceFrozen = FALSE;		// Set while dumping
+static uint16 twiTraceJobStart;
+static uint16 twiTraceLatencyCount = 0;
+static uint16 twiTraceLatencyMinimum = 0xFFFF;
+static uint16 twiTraceLatencyMaximum = 0;
+static uint32 twiTraceLatencySum = 0;
+static uint8 twiTraceLatencyAddress = 0;
+#endif
+
+// -----------------------------------------------------------------------------
+// Private functions declaration -----------------------------------------------
+
+static void twiMasterStartNextJob(void);
+static void twiMasterFinishJob(twiState_t state);
+static void twiMasterStatisticsIncrement(volatile uint16 * counter);
+#ifdef TWI_MASTER_TRACE
+static void twiMasterTraceLatency(uint8 address);
+#endif
 
 // -----------------------------------------------------------------------------
 // Public function definitions -------------------------------------------------
@@ -87,50 +129,54 @@ twiResult_t twiMasterInit(uint32 clockSpeed)
  * 				message				message to be transmitted
  * 				messageSize			number of bytes to be sent or read
  * Returns:		TWI_OK
- * Notes:		When reading the device, the bytes received will be available
- * 				in message argument
+ * Notes:		The message is transferred directly from/to the message
+ * 				argument, which must remain valid until the transmission ends
+ * 				(twiMasterIsBusy() returns FALSE). When reading the device, the
+ * 				function waits and the received bytes are available in message
  * -------------------------------------------------------------------------- */
 
-twiResult_t twiMasterSendData(uint8 deviceAddress, uint8 readWrite, uint8 *message, uint8 messageSize)
+twiResult_t twiMasterSendData(uint8 deviceAddress, uint8 readWrite, uint8 *message, uint16 messageSize)
 {
-	uint8 i;
-
 	while(twiMasterIsBusy())
 		;	// Wait until TWI is ready for next transmission.
-	twiBufferData[0] = (deviceAddress << 1) |  readWrite;
-	twiBufferSize = messageSize + 1;
-	if(readWrite == TWI_MASTER_WRITE){
-		for(i = 0;i < messageSize;i++)
-			twiBufferData[i + 1] = message[i];
-	}
+	twiSendDataJob.address = deviceAddress;
+	twiSendDataJob.readWrite = readWrite;
+	twiSendDataJob.buffer = message;
+	twiSendDataJob.size = messageSize;
+	twiSendDataJob.rxBuffer = NULL;
+	twiSendDataJob.rxSize = 0;
+	twiSendDataJob.callback = NULL;
 	twiStatus.all = 0;
 	twiState = TWI_NO_STATE;
-	TWCR = (1 << TWEN) | (1 << TWIE) | (1 << TWINT) | (1 << TWSTA);
+	twiMasterSubmit(&twiSendDataJob);
 	if(readWrite == TWI_MASTER_READ){
 		twiMasterReadFromBuffer(message, messageSize);
+		if(twiSendDataJob.status == TWI_JOB_TIMEOUT)
+			return TWI_TIMEOUT_ERROR;
 	}
 	return TWI_OK;
 }
 
 /* -----------------------------------------------------------------------------
  * Function:	twiMasterReadFromBuffer
- * Purpose:		Reads data from buffer after a reception
+ * Purpose:		Waits for the end of a reception started by twiMasterSendData
  * Arguments:	message				pointer to where data must be copied into
  * 				messageSize			number of bytes to be read from buffer
  * Returns:		TRUE, FALSE
  * Notes:		This function must be called after a call to twiMasterSendData
- * 				in read mode
+ * 				in read mode. The data is only copied if message is not the
+ * 				buffer given to twiMasterSendData
  * -------------------------------------------------------------------------- */
 
-bool_t twiMasterReadFromBuffer(uint8 *message, uint8 messageSize)
+bool_t twiMasterReadFromBuffer(uint8 *message, uint16 messageSize)
 {
-	uint8 i;
-
 	while(twiMasterIsBusy())
 		;	// Wait until TWI is ready for next transmission
 	if(twiStatus.lastTransOK){			// Last transmission competed successfully
-		for(i = 0;i < messageSize;i++){	// Copy data from Transceiver buffer
-			message[i] = twiBufferData[i + 1];
+		if(message != twiSendDataJob.buffer){
+			if(messageSize > twiSendDataJob.size)
+				messageSize = twiSendDataJob.size;
+			memcpy(message, twiSendDataJob.buffer, messageSize);
 		}
 		return TRUE;
 	}
@@ -150,8 +196,7 @@ twiResult_t twiMasterResendData(void)
 		;	// Wait until TWI is ready for next transmission
 	twiStatus.all = 0;
 	twiState = TWI_NO_STATE;
-	TWCR = (1 << TWEN) | (1 << TWIE) | (1 << TWINT) | (1 << TWSTA);
-	return TWI_OK;
+	return twiMasterSubmit(&twiSendDataJob);
 }
 
 /* -----------------------------------------------------------------------------
@@ -169,19 +214,433 @@ twiState_t twiMasterErrorHandler(twiState_t twiErrorCode)
 	return twiErrorCode;
 }
 
+/* -----------------------------------------------------------------------------
+ * Function:	twiMasterSubmit
+ * Purpose:		Queues a transaction without blocking. Queued transactions are
+ * 				chained by the interruption handler with repeated START
+ * 				conditions, and a STOP condition is sent after the last one
+ * Arguments:	job				transaction to be queued
+ * Returns:		TWI_OK or TWI_QUEUE_FULL
+ * Notes:		The job status is set to TWI_JOB_DONE or TWI_JOB_FAILED and its
+ * 				callback is called (in interrupt context) at completion. This
+ * 				function may be called from a callback to submit a follow-up
+ * 				transaction
+ * -------------------------------------------------------------------------- */
+
+twiResult_t twiMasterSubmit(twiMasterJob_t * job)
+{
+	twiResult_t result = TWI_OK;
+
+	if(isBitSet(SREG, SREG_I))				// Not called from a callback
+		twiMasterService();
+	job->status = TWI_JOB_QUEUED;
+	job->state = TWI_NO_STATE;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		if(!twiJobQueuePush(job)){
+			result = TWI_QUEUE_FULL;
+		}else if((twiCurrentJob == NULL) && !twiRecoveryPending){	// Bus idle
+			twiMasterStartNextJob();
+			TWCR = (1 << TWEN) | (1 << TWIE) | (1 << TWINT) | (1 << TWSTA);
+		}
+	}
+
+	return result;
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiMasterWriteRead
+ * Purpose:		Writes data to a slave device and reads its answer after a
+ * 				repeated START, in a single transaction (e.g. register reads)
+ * Arguments:	deviceAddress		Bus address of the slave device
+ * 				txMessage			data to be sent (e.g. register address)
+ * 				txSize				number of bytes to be sent
+ * 				rxMessage			buffer for the received data
+ * 				rxSize				number of bytes to be read
+ * Returns:		TWI_OK, TWI_QUEUE_FULL or TWI_TRANSFER_ERROR
+ * Notes:		Waits until the transaction ends. For a non-blocking register
+ * 				read, submit a write job with rxBuffer and rxSize set
+ * -------------------------------------------------------------------------- */
+
+twiResult_t twiMasterWriteRead(uint8 deviceAddress, uint8 * txMessage, uint16 txSize, uint8 * rxMessage, uint16 rxSize)
+{
+	twiMasterJob_t job;
+	twiResult_t result;
+
+	job.address = deviceAddress;
+	job.readWrite = TWI_MASTER_WRITE;
+	job.buffer = txMessage;
+	job.size = txSize;
+	job.rxBuffer = rxMessage;
+	job.rxSize = rxSize;
+	job.callback = NULL;
+	result = twiMasterSubmit(&job);
+	if(result != TWI_OK)
+		return result;
+	while((job.status == TWI_JOB_QUEUED) || (job.status == TWI_JOB_RUNNING))
+		twiMasterService();	// Wait until the transaction ends (bounded by twiMasterTimeoutTick())
+
+	if(job.status == TWI_JOB_TIMEOUT)
+		return TWI_TIMEOUT_ERROR;
+	return (job.status == TWI_JOB_DONE) ? TWI_OK : TWI_TRANSFER_ERROR;
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiMasterTimeoutTick
+ * Purpose:		Supervises the current transaction. If the bus shows no
+ * 				activity for TWI_MASTER_TIMEOUT calls, the transaction is
+ * 				aborted (status TWI_JOB_TIMEOUT) and a bus recovery is left
+ * 				pending for twiMasterService()
+ * Arguments:	none
+ * Returns:		none
+ * Notes:		Must be called periodically from a timer interruption handler
+ * 				(e.g. every 1 ms), so the waits of this module are bounded. It
+ * 				never bit-bangs the bus, so it stays short
+ * -------------------------------------------------------------------------- */
+
+void twiMasterTimeoutTick(void)
+{
+	twiMasterJob_t * job = NULL;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		if(twiCurrentJob == NULL){
+			twiTimeoutCounter = TWI_MASTER_TIMEOUT;
+		}else if(twiTimeoutCounter > 0){
+			twiTimeoutCounter--;
+		}else{
+			job = twiCurrentJob;
+			TWCR = (1 << TWEN);					// Stop the interruptions
+			twiCurrentJob = NULL;
+			twiRecoveryPending = TRUE;
+			twiMasterStatisticsIncrement(&twiBusStatistics.timeouts);
+			twiState = TWI_BUS_ERROR;
+			twiStatus.lastTransOK = FALSE;
+			job->state = TWI_BUS_ERROR;
+			job->status = TWI_JOB_TIMEOUT;
+#ifdef TWI_MASTER_TRACE
+			twiMasterTraceLatency(job->address);
+#endif
+		}
+	}
+	if((job != NULL) && (job->callback != NULL))
+		job->callback(job);
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiMasterService
+ * Purpose:		Recovers the bus after a timeout and restarts the queued
+ * 				transactions
+ * Arguments:	none
+ * Returns:		none
+ * Notes:		Must be called from the main code (interruptions enabled), as
+ * 				the recovery takes up to about 1 ms. It is called by the
+ * 				blocking functions, twiMasterSubmit() and twiMasterIsBusy(), so
+ * 				an explicit call is only needed by fully non-blocking code
+ * -------------------------------------------------------------------------- */
+
+void twiMasterService(void)
+{
+	if(!twiRecoveryPending)
+		return;
+	twiMasterRecoverBus();
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		twiRecoveryPending = FALSE;
+		twiMasterStartNextJob();
+		if(twiCurrentJob != NULL)
+			TWCR = (1 << TWEN) | (1 << TWIE) | (1 << TWINT) | (1 << TWSTA);
+	}
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiMasterRecoverBus
+ * Purpose:		Frees a bus held by a slave: disables the TWI module, clocks
+ * 				up to 9 pulses on SCL until SDA is released, generates a STOP
+ * 				condition by hand and enables the module again with the same
+ * 				bit rate
+ * Arguments:	none
+ * Returns:		TWI_OK or TWI_BUS_HANG_ERROR if SDA is still held low
+ * Notes:		Must not be called while a transaction is running nor with the
+ * 				interruptions disabled; it is called by twiMasterService()
+ * 				after a timeout
+ * -------------------------------------------------------------------------- */
+
+twiResult_t twiMasterRecoverBus(void)
+{
+	uint8 i;
+	uint8 wait;
+	twiResult_t result = TWI_OK;
+
+	TWCR = 0;								// SDA and SCL become general I/O
+	clrBit(TWI_PORT, TWI_SDA);				// Open-drain: pull low with DDR = 1
+	clrBit(TWI_PORT, TWI_SCL);
+	clrBit(TWI_DDR, TWI_SDA);
+	clrBit(TWI_DDR, TWI_SCL);
+	_delay_us(5);
+
+	for(i = 0;(i < 9) && isBitClr(TWI_PIN, TWI_SDA);i++){
+		setBit(TWI_DDR, TWI_SCL);			// SCL low
+		_delay_us(5);
+		clrBit(TWI_DDR, TWI_SCL);			// SCL released
+		for(wait = 0;(wait < 100) && isBitClr(TWI_PIN, TWI_SCL);wait++)
+			_delay_us(1);					// Clock stretching
+		_delay_us(5);
+	}
+
+	// STOP condition: SDA rises while SCL is high
+	setBit(TWI_DDR, TWI_SCL);
+	setBit(TWI_DDR, TWI_SDA);
+	_delay_us(5);
+	clrBit(TWI_DDR, TWI_SCL);
+	_delay_us(5);
+	clrBit(TWI_DDR, TWI_SDA);
+	_delay_us(5);
+
+	if(isBitClr(TWI_PIN, TWI_SDA)){
+		twiMasterStatisticsIncrement(&twiBusStatistics.recoveryFailures);
+		result = TWI_BUS_HANG_ERROR;
+	}else{
+		twiMasterStatisticsIncrement(&twiBusStatistics.recoveries);
+	}
+
+	// TWBR and the prescaler bits of TWSR are kept by the module
+	TWDR = 0xFF;							// Release SDA
+	TWCR = 1 << TWEN;						// Activate TWI interface
+
+	return result;
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiMasterGetBusStatistics
+ * Purpose:		Copies the bus health counters
+ * Arguments:	statistics		pointer to where the counters must be copied
+ * Returns:		none
+ * -------------------------------------------------------------------------- */
+
+void twiMasterGetBusStatistics(twiMasterBusStatistics_t * statistics)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		statistics->timeouts = twiBusStatistics.timeouts;
+		statistics->recoveries = twiBusStatistics.recoveries;
+		statistics->recoveryFailures = twiBusStatistics.recoveryFailures;
+	}
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiMasterResetBusStatistics
+ * Purpose:		Clears the bus health counters
+ * Arguments:	none
+ * Returns:		none
+ * -------------------------------------------------------------------------- */
+
+void twiMasterResetBusStatistics(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		twiBusStatistics.timeouts = 0;
+		twiBusStatistics.recoveries = 0;
+		twiBusStatistics.recoveryFailures = 0;
+	}
+}
+
+#ifdef TWI_MASTER_TRACE
+/* -----------------------------------------------------------------------------
+ * Function:	twiMasterTraceDump
+ * Purpose:		Prints the recorded events, oldest first, as "timestamp status
+ * 				data" lines, followed by the latency statistics
+ * Arguments:	stream			output stream (e.g. &usartBufferedStream)
+ * Returns:		none
+ * Notes:		Recording is suspended while the trace is printed
+ * -------------------------------------------------------------------------- */
+
+void twiMasterTraceDump(FILE * stream)
+{
+	char line[24];
+	char * aux;
+	uint8 i;
+	uint8 index;
+	twiMasterTraceEntry_t * entry;
+	twiMasterLatency_t latency;
+
+	twiTraceFrozen = TRUE;
+	index = twiTraceIndex;
+	for(i = index - twiTraceCount;i != index;i++){
+		entry = &twiTraceBuffer[i & (TWI_TRACE_SIZE - 1)];
+		aux = fmtU16(line, entry->timestamp);
+		*aux++ = ' ';
+		aux = fmtHex8(aux, entry->status);
+		*aux++ = ' ';
+		aux = fmtHex8(aux, entry->data);
+		*aux++ = '\n';
+		*aux = '\0';
+		fputs(line, stream);
+	}
+	twiTraceFrozen = FALSE;
+
+	twiMasterGetLatency(&latency);
+	fputs_P(PSTR("latency min/avg/max: "), stream);
+	aux = fmtU16(line, latency.minimum);
+	*aux++ = '/';
+	aux = fmtU16(aux, latency.average);
+	*aux++ = '/';
+	aux = fmtU16(aux, latency.maximum);
+	fputs(line, stream);
+	fputs_P(PSTR(" slowest: 0x"), stream);
+	aux = fmtHex8(line, latency.maximumAddress);
+	*aux++ = '\n';
+	*aux = '\0';
+	fputs(line, stream);
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiMasterGetLatency
+ * Purpose:		Copies the latency statistics of the transactions, measured
+ * 				from the START request to the completion
+ * Arguments:	latency			pointer to where the statistics must be copied
+ * Returns:		none
+ * -------------------------------------------------------------------------- */
+
+void twiMasterGetLatency(twiMasterLatency_t * latency)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		latency->count = twiTraceLatencyCount;
+		latency->minimum = (twiTraceLatencyCount > 0) ? twiTraceLatencyMinimum : 0;
+		latency->average = (twiTraceLatencyCount > 0) ? (uint16)(twiTraceLatencySum / twiTraceLatencyCount) : 0;
+		latency->maximum = twiTraceLatencyMaximum;
+		latency->maximumAddress = twiTraceLatencyAddress;
+	}
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiMasterTraceReset
+ * Purpose:		Clears the recorded events and the latency statistics
+ * Arguments:	none
+ * Returns:		none
+ * -------------------------------------------------------------------------- */
+
+void twiMasterTraceReset(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		twiTraceIndex = 0;
+		twiTraceCount = 0;
+		twiTraceLatencyCount = 0;
+		twiTraceLatencyMinimum = 0xFFFF;
+		twiTraceLatencyMaximum = 0;
+		twiTraceLatencySum = 0;
+		twiTraceLatencyAddress = 0;
+	}
+}
+#endif
+
 // -----------------------------------------------------------------------------
 // Private function definitions ------------------------------------------------
 
+#ifdef TWI_MASTER_TRACE
+/* -----------------------------------------------------------------------------
+ * Function:	twiMasterTraceLatency
+ * Purpose:		Updates the latency statistics with the current transaction
+ * Arguments:	address			address of the device
+ * Returns:		none
+ * Notes:		Called with the interruptions disabled only
+ * -------------------------------------------------------------------------- */
+
+static void twiMasterTraceLatency(uint8 address)
+{
+	uint16 latency = TWI_TRACE_TIMESTAMP() - twiTraceJobStart;
+
+	if(twiTraceLatencyCount == 0xFFFF)
+		return;		// Average would overflow
+	twiTraceLatencyCount++;
+	twiTraceLatencySum += latency;
+	if(latency < twiTraceLatencyMinimum)
+		twiTraceLatencyMinimum = latency;
+	if(latency > twiTraceLatencyMaximum){
+		twiTraceLatencyMaximum = latency;
+		twiTraceLatencyAddress = address;
+	}
+}
+#endif
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiMasterStartNextJob
+ * Purpose:		Takes the next transaction from the queue
+ * Arguments:	none
+ * Returns:		none
+ * Notes:		Must be called with the interruptions disabled
+ * -------------------------------------------------------------------------- */
+
+static void twiMasterStartNextJob(void)
+{
+	twiMasterJob_t * job;
+
+	twiTimeoutCounter = TWI_MASTER_TIMEOUT;
+	if(twiJobQueuePop(&job)){
+#ifdef TWI_MASTER_TRACE
+		twiTraceJobStart = TWI_TRACE_TIMESTAMP();
+#endif
+		job->status = TWI_JOB_RUNNING;
+		twiReadPhase = (job->readWrite == TWI_MASTER_READ);
+		twiCurrentJob = job;
+	}else{
+		twiCurrentJob = NULL;
+	}
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiMasterStatisticsIncrement
+ * Purpose:		Increments a bus health counter, saturating at 65535
+ * Arguments:	counter			pointer to the counter
+ * Returns:		none
+ * -------------------------------------------------------------------------- */
+
+static void twiMasterStatisticsIncrement(volatile uint16 * counter)
+{
+	if(*counter < 0xFFFF)
+		(*counter)++;
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiMasterFinishJob
+ * Purpose:		Completes the current transaction and starts the next queued
+ * 				one with a repeated START, or releases the bus with a STOP
+ * Arguments:	state			TWI_NO_STATE on success, or the failing state
+ * Returns:		none
+ * Notes:		Called by the interruption handler only
+ * -------------------------------------------------------------------------- */
+
+static void twiMasterFinishJob(twiState_t state)
+{
+	twiMasterJob_t * job = twiCurrentJob;
+
+	twiState = state;
+	twiStatus.lastTransOK = (state == TWI_NO_STATE);
+#ifdef TWI_MASTER_TRACE
+	twiMasterTraceLatency(job->address);
+#endif
+	job->state = state;
+	job->status = (state == TWI_NO_STATE) ? TWI_JOB_DONE : TWI_JOB_FAILED;
+	if(job->callback != NULL)
+		job->callback(job);
+
+	twiMasterStartNextJob();
+	if(twiCurrentJob == NULL){				// Send STOP after the last job
+		TWCR = (1 << TWEN) | (1 << TWINT) | (1 << TWSTO);
+	}else if(state == TWI_NO_STATE){		// Chain the next job
+		TWCR = (1 << TWEN) | (1 << TWIE) | (1 << TWINT) | (1 << TWSTA);
+	}else{									// Release the slave first
+		TWCR = (1 << TWEN) | (1 << TWIE) | (1 << TWINT) | (1 << TWSTO) | (1 << TWSTA);
+	}
+}
+
 /* -----------------------------------------------------------------------------
  * Function:	twiMasterIsBusy
- * Purpose:		Checks if transceiver is busy
+ * Purpose:		Checks if transceiver is busy, running a pending bus recovery
  * Arguments:	none
  * Returns:		TRUE, FALSE
  * -------------------------------------------------------------------------- */
 
 bool_t twiMasterIsBusy(void)
 {
-	if(isBitSet(TWCR, TWIE))
+	if(isBitSet(SREG, SREG_I))
+		twiMasterService();
+	if((twiCurrentJob != NULL) || twiRecoveryPending || isBitSet(TWCR, TWIE))
 		return TRUE;
 	return FALSE;
 }
@@ -205,50 +664,84 @@ twiState_t twiMasterGetStatus(void)
 
 /* -----------------------------------------------------------------------------
  * Handler:		TWI_vect
- * Purpose:		Manages the TWI interruption
+ * Purpose:		Manages the TWI interruption, transferring the current job
  * -------------------------------------------------------------------------- */
 
 ISR(TWI_vect)
 {
-	static uint8 twiBufferPointer;
+	static uint16 twiBufferPointer;
+	static uint8 * twiData;
+	static uint16 twiDataSize;
+	twiMasterJob_t * job = twiCurrentJob;
+	uint8 status = TWSR & 0xF8;
+#ifdef TWI_MASTER_TRACE
+	twiMasterTraceEntry_t * entry;
 
-	switch(TWSR & 0xFC){
+	if(!twiTraceFrozen){
+		entry = &twiTraceBuffer[twiTraceIndex & (TWI_TRACE_SIZE - 1)];
+		entry->status = status;
+		entry->data = TWDR;
+		entry->timestamp = TWI_TRACE_TIMESTAMP();
+		twiTraceIndex++;
+		if(twiTraceCount < TWI_TRACE_SIZE)
+			twiTraceCount++;
+	}
+#endif
+
+	twiTimeoutCounter = TWI_MASTER_TIMEOUT;	// Bus activity
+	if(job == NULL){						// Aborted by twiMasterTimeoutTick()
+		TWCR = (1 << TWEN);
+		return;
+	}
+	switch(status){
 	case TWI_START:			// START has been transmitted
 	case TWI_REP_START:		// Repeated START has been transmitted
-		twiBufferPointer = 0;	// Set buffer pointer to the TWI Address location
+		twiBufferPointer = 0;
+		if(twiReadPhase && (job->readWrite == TWI_MASTER_WRITE)){	// Write-then-read
+			twiData = job->rxBuffer;
+			twiDataSize = job->rxSize;
+		}else{
+			twiData = job->buffer;
+			twiDataSize = job->size;
+		}
+		TWDR = (job->address << 1) | (twiReadPhase ? TWI_MASTER_READ : TWI_MASTER_WRITE);
+		TWCR = (1 << TWEN) | (1 << TWIE) | (1 << TWINT);
+		break;
 	case TWI_MTX_ADR_ACK:		// SLA+W has been transmitted and ACK received
 	case TWI_MTX_DATA_ACK:		// Data byte has been transmitted and ACK received
-		if(twiBufferPointer < twiBufferSize){
-			TWDR = twiBufferData[twiBufferPointer++];
+		if(twiBufferPointer < twiDataSize){
+			TWDR = twiData[twiBufferPointer++];
 			TWCR = (1 << TWEN) | (1 << TWIE) | (1 << TWINT);
-		}else{			// Send STOP after last byte
-			twiStatus.lastTransOK = TRUE;	// Set status bits to completed successfully
-			TWCR = (1 << TWEN) | (1 << TWINT) | (1 << TWSTO);
+		}else if(job->rxSize > 0){	// Turn the bus around with a repeated START
+			twiReadPhase = TRUE;
+			TWCR = (1 << TWEN) | (1 << TWIE) | (1 << TWINT) | (1 << TWSTA);
+		}else{			// Last byte sent
+			twiMasterFinishJob(TWI_NO_STATE);
 		}
 		break;
 	case TWI_MRX_DATA_ACK:		// Data byte has been received and ACK transmitted
-		twiBufferData[twiBufferPointer++] = TWDR;
+		twiData[twiBufferPointer++] = TWDR;
 	case TWI_MRX_ADR_ACK:		// SLA+R has been transmitted and ACK received
-		if(twiBufferPointer < (twiBufferSize - 1))	// Detect the last byte to NACK it
+		if((twiBufferPointer + 1) < twiDataSize)	// Detect the last byte to NACK it
 			TWCR = (1 << TWEN) | (1 << TWIE) | (1 << TWINT) | (1 << TWEA);
 		else					// Send NACK after next reception
 			TWCR = (1 << TWEN) | (1 << TWIE) | (1 << TWINT);
 		break;
 	case TWI_MRX_DATA_NACK:		// Data byte has been received and NACK transmitted
-		twiBufferData[twiBufferPointer] = TWDR;
-		twiStatus.lastTransOK = TRUE;	// Set status bits to completed successfully
-		TWCR = (1 << TWEN) | (1 << TWINT) | (1 << TWSTO);
+		if(twiBufferPointer < twiDataSize)
+			twiData[twiBufferPointer] = TWDR;
+		twiMasterFinishJob(TWI_NO_STATE);
 		break;
 	case TWI_ARB_LOST:			// Arbitration lost
+		twiReadPhase = (job->readWrite == TWI_MASTER_READ);	// Restart the whole job
 		TWCR = (1 << TWEN) | (1 << TWIE) | (1 << TWINT) | (1 << TWSTA);
 		break;
 	case TWI_MTX_ADR_NACK:		// SLA+W has been transmitted and NACK received
-	case TWI_MRX_ADR_NACK:		// SLA+R has been transmitted and NACK received    
+	case TWI_MRX_ADR_NACK:		// SLA+R has been transmitted and NACK received
 	case TWI_MTX_DATA_NACK:		// Data byte has been transmitted and NACK received
 	case TWI_BUS_ERROR:			// Bus error due to an illegal START or STOP condition
 	default:
-		twiState = TWSR;		// Store TWSR and automatically sets clears noErrors bit
-		TWCR = (1 << TWEN);		// Reset TWI Interface
+		twiMasterFinishJob(status);
 		break;
 	}
-}
\ No newline at end of file
+}
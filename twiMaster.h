@@ -31,15 +31,34 @@
 #ifndef TWI_GENERAL_CALL_ADDRESS
 	#define TWI_GENERAL_CALL_ADDRESS	0x00
 #endif
-#ifndef TWI_BUFFER_SIZE
-	#define TWI_BUFFER_SIZE				10
-#endif
 #ifndef TWI_MASTER_READ
 	#define TWI_MASTER_READ				1
 #endif
 #ifndef TWI_MASTER_WRITE
 	#define TWI_MASTER_WRITE			0
 #endif
+// Number of twiMasterTimeoutTick() calls without bus activity after which
+// the current transaction is aborted; the bus is then recovered by
+// twiMasterService(), from the main code
+#ifndef TWI_MASTER_TIMEOUT
+	#define TWI_MASTER_TIMEOUT			10
+#endif
+// Define TWI_MASTER_TRACE to record every TWI_vect event (status, data byte
+// and timestamp) into a ring of TWI_TRACE_SIZE entries (power of two up to
+// 128) and to measure the latency of each transaction. TWI_TRACE_TIMESTAMP()
+// reads the time base, timer1 by default, which must be left running.
+#ifdef TWI_MASTER_TRACE
+	#ifndef TWI_TRACE_SIZE
+		#define TWI_TRACE_SIZE			32
+	#endif
+	#ifndef TWI_TRACE_TIMESTAMP
+		#define TWI_TRACE_TIMESTAMP()	TCNT1
+	#endif
+#endif
+// Maximum number of queued transactions (power of two up to 128)
+#ifndef TWI_JOB_QUEUE_SIZE
+	#define TWI_JOB_QUEUE_SIZE			4
+#endif
 
 // -----------------------------------------------------------------------------
 // New data types --------------------------------------------------------------
@@ -61,9 +80,27 @@ typedef enum twiGeneralCallEnable_t{
 
 typedef enum twiResult_t{
 	TWI_OK					= 0,
-	TWI_CLOCK_SPEED_ERROR	= 1
+	TWI_CLOCK_SPEED_ERROR	= 1,
+	TWI_QUEUE_FULL			= 2,
+	TWI_TRANSFER_ERROR		= 3,
+	TWI_TIMEOUT_ERROR		= 4,
+	TWI_BUS_HANG_ERROR		= 5
 } twiResult_t;
 
+typedef enum twiJobStatus_t{
+	TWI_JOB_QUEUED			= 0,	// Waiting in the queue
+	TWI_JOB_RUNNING			= 1,	// Being transferred
+	TWI_JOB_DONE			= 2,	// Completed successfully
+	TWI_JOB_FAILED			= 3,	// Failed; the bus state is stored in state
+	TWI_JOB_TIMEOUT			= 4		// Aborted by twiMasterTimeoutTick()
+} twiJobStatus_t;
+
+typedef struct twiMasterBusStatistics_t{
+	uint16 timeouts;						// Transactions aborted by timeout
+	uint16 recoveries;						// Bus recoveries that released SDA
+	uint16 recoveryFailures;				// Bus recoveries with SDA still held low
+} twiMasterBusStatistics_t;
+
 typedef enum twiState_t{
 	TWI_START					= 0x08,	// START has been transmitted  
 	TWI_REP_START				= 0x10,	// Repeated START has been transmitted
@@ -94,6 +131,39 @@ typedef enum twiState_t{
 	TWI_BUS_ERROR				= 0x00	// Bus error due to an illegal START or STOP condition
 } twiState_t;
 
+typedef struct twiMasterJob_t twiMasterJob_t;
+typedef void (* twiMasterCallback_t)(twiMasterJob_t * job);
+
+// Transaction submitted with twiMasterSubmit(). The structure and the buffers
+// must remain valid until status becomes TWI_JOB_DONE or TWI_JOB_FAILED. A
+// write job with rxSize > 0 reads rxSize bytes into rxBuffer after a repeated
+// START (write-then-read)
+struct twiMasterJob_t{
+	uint8 address;							// 7-bit slave address
+	uint8 readWrite;						// TWI_MASTER_READ or TWI_MASTER_WRITE
+	uint8 * buffer;							// Data to be sent or received
+	uint16 size;							// Number of bytes
+	uint8 * rxBuffer;						// Write-then-read reception buffer
+	uint16 rxSize;							// Write-then-read bytes to receive
+	twiMasterCallback_t callback;			// Called by TWI_vect at completion, or NULL
+	volatile twiJobStatus_t status;
+	volatile twiState_t state;				// TWI_NO_STATE or the failing bus state
+};
+
+typedef struct twiMasterTraceEntry_t{
+	uint8 status;							// TWSR & 0xF8
+	uint8 data;								// TWDR (byte moved)
+	uint16 timestamp;						// TWI_TRACE_TIMESTAMP()
+} twiMasterTraceEntry_t;
+
+typedef struct twiMasterLatency_t{
+	uint16 count;							// Transactions measured
+	uint16 minimum;							// In TWI_TRACE_TIMESTAMP() ticks
+	uint16 average;
+	uint16 maximum;
+	uint8 maximumAddress;					// Device of the slowest transaction
+} twiMasterLatency_t;
+
 // -----------------------------------------------------------------------------
 // Global variables ------------------------------------------------------------
 
@@ -103,10 +173,22 @@ extern twiStatus_t twiStatus;
 // Public functions declaration ------------------------------------------------
 
 twiResult_t	twiMasterInit(uint32 clockSpeed);
-twiResult_t	twiMasterSendData(uint8 deviceAddress, uint8 readWrite, uint8 *message, uint8 messageSize);
-bool_t		twiMasterReadFromBuffer(uint8 *message, uint8 messageSize);
+twiResult_t	twiMasterSendData(uint8 deviceAddress, uint8 readWrite, uint8 *message, uint16 messageSize);
+bool_t		twiMasterReadFromBuffer(uint8 *message, uint16 messageSize);
 twiResult_t	twiMasterResendData(void);
 twiState_t	twiMasterErrorHandler(twiState_t twiErrorCode);
+twiResult_t	twiMasterSubmit(twiMasterJob_t * job);
+twiResult_t	twiMasterWriteRead(uint8 deviceAddress, uint8 * txMessage, uint16 txSize, uint8 * rxMessage, uint16 rxSize);
+void		twiMasterTimeoutTick(void);
+void		twiMasterService(void);
+twiResult_t	twiMasterRecoverBus(void);
+void		twiMasterGetBusStatistics(twiMasterBusStatistics_t * statistics);
+void		twiMasterResetBusStatistics(void);
+#ifdef TWI_MASTER_TRACE
+void		twiMasterTraceDump(FILE * stream);
+void		twiMasterGetLatency(twiMasterLatency_t * latency);
+void		twiMasterTraceReset(void);
+#endif
 
 // -----------------------------------------------------------------------------
 // Private functions declaration - do not use outside this module --------------
@@ -5,8 +5,10 @@
  * Author:			Leandro Schwarz
  *					Hazael dos Santos Batista
  * Build:			1
- * Last edition:	September 18, 2017
- * Purpose:			Interfaces a TWI Slave data bus
+ * Last edition:	October 17, 2026
+ * Purpose:			Interfaces a TWI Slave data bus, either as a raw buffer or as
+ *					a register map with a double-buffered read-only region and
+ *					a read-write region
  * -------------------------------------------------------------------------- */
 
 // -----------------------------------------------------------------------------
@@ -16,6 +18,10 @@
 #if __TWI_SLAVE_H != 1
 	#error Error 101 - Build mismatch on header and source code files (twiSlave).
 #endif
+#ifdef TWI_SLAVE_REGISTER_MAP
+	#include <string.h>
+	#include <util/atomic.h>
+#endif
 
 // -----------------------------------------------------------------------------
 // Global variables ------------------------------------------------------------
@@ -26,39 +32,281 @@ static vuint8 twiBufferSize = 0;
 static vuint8 twiCommIndex = 0;
 static vuint8 twiBusy = 0;
 
+#ifdef TWI_SLAVE_REGISTER_MAP
+static uint8 twiReadOnlyBuffer[2][TWI_SLAVE_READ_ONLY_SIZE];
+static uint8 twiReadOnlySize = 0;
+static vuint8 twiReadOnlyFront = 0;			// Buffer seen by the master
+static volatile bool_t twiReadOnlyReady = FALSE;	// Back buffer published, swap on next address match
+static volatile bool_t twiReadOnlySwapped = FALSE;	// Back buffer is older than the front buffer
+static twiBuffer_t twiReadWriteBuffer[TWI_SLAVE_READ_WRITE_SIZE];
+static vuint8 twiReadWriteDirty[(TWI_SLAVE_READ_WRITE_SIZE + 7) / 8];
+static bool_t twiRegisterMapActive = FALSE;
+static twiSlaveWrap_t twiWrap = TWI_SLAVE_WRAP_MAP;
+static twiSlaveWriteCallback_t twiWriteCallback = NULL;
+static vuint8 twiWriteFirst = 0;			// First register of the current run of stored bytes
+static vuint8 twiWriteCount = 0;			// Length of the current run
+#endif
+
+// -----------------------------------------------------------------------------
+// Private functions declaration -----------------------------------------------
+
+static void twiSlaveEnable(uint8 twiSlaveAddr, bool_t genCallAcceptance);
+static uint8 twiSlaveReadMap(uint8 reg);
+static bool_t twiSlaveWriteMap(uint8 reg, uint8 data);
+static uint8 twiSlaveNextRegister(uint8 reg);
+#ifdef TWI_SLAVE_REGISTER_MAP
+static void twiSlaveSwapReadOnly(void);
+static void twiSlaveWriteRun(uint8 reg);
+static void twiSlaveWriteReport(void);
+#endif
+
 // -----------------------------------------------------------------------------
 // Public function definitions -------------------------------------------------
 
+// Raw buffer mode: the returned buffer is read and written by the master
+// without any synchronization, starting at the index sent after SLA+W
 twiBuffer_t * twiSlaveInit(uint8 twiSlaveAddr, uint8 bufferSize, bool_t genCallAcceptance)
 {
+	twiBufferData = (twiBuffer_t *)calloc(bufferSize, sizeof(uint8));
+
+	if(twiBufferData == NULL) {
+		return NULL;
+	}
+
+	twiBufferSize = bufferSize;
+#ifdef TWI_SLAVE_REGISTER_MAP
+	twiReadOnlySize = 0;
+	twiRegisterMapActive = FALSE;
+	twiWrap = TWI_SLAVE_WRAP_MAP;
+	twiWriteCallback = NULL;
+#endif
+	twiSlaveEnable(twiSlaveAddr, genCallAcceptance);
+
+	return twiBufferData;
+}
+
+#ifdef TWI_SLAVE_REGISTER_MAP
+// Register map mode: TWI_SLAVE_READ_ONLY_SIZE registers published through
+// twiSlaveBeginUpdate()/twiSlaveEndUpdate(), followed by
+// TWI_SLAVE_READ_WRITE_SIZE registers written by the master
+void twiSlaveRegisterMapInit(uint8 twiSlaveAddr, twiSlaveWrap_t wrap, twiSlaveWriteCallback_t callback, bool_t genCallAcceptance)
+{
+	twiBufferData = twiReadWriteBuffer;
+	twiBufferSize = TWI_SLAVE_READ_WRITE_SIZE;
+	twiReadOnlySize = TWI_SLAVE_READ_ONLY_SIZE;
+	twiReadOnlyFront = 0;
+	twiReadOnlyReady = FALSE;
+	twiReadOnlySwapped = FALSE;
+	memset((void *)twiReadWriteDirty, 0, sizeof(twiReadWriteDirty));
+	twiRegisterMapActive = TRUE;
+	twiWrap = wrap;
+	twiWriteCallback = callback;
+	twiSlaveEnable(twiSlaveAddr, genCallAcceptance);
+}
+
+// Returns the back buffer of the read-only region, holding the last published
+// values. The master keeps reading the front buffer until twiSlaveEndUpdate()
+uint8 * twiSlaveBeginUpdate(void)
+{
+	uint8 * back;
+
+	twiReadOnlyReady = FALSE;
+	back = twiReadOnlyBuffer[twiReadOnlyFront ^ 1];
+	if(twiReadOnlySwapped) {
+		memcpy(back, twiReadOnlyBuffer[twiReadOnlyFront], TWI_SLAVE_READ_ONLY_SIZE);
+		twiReadOnlySwapped = FALSE;
+	}
+
+	return back;
+}
+
+// Publishes the back buffer; it becomes visible to the master as a whole at
+// the next address match
+void twiSlaveEndUpdate(void)
+{
+	__asm__ __volatile__("" ::: "memory");	// Back buffer stores complete first
+	twiReadOnlyReady = TRUE;
+}
+
+// Reads a read-write register (map address) and clears its dirty flag.
+// Returns TRUE if the master wrote it since the last call, and FALSE without
+// reading if the register map is not active (raw buffer mode)
+bool_t twiSlaveGetRegister(uint8 reg, uint8 * value)
+{
+	bool_t dirty = FALSE;
+
+	reg -= twiReadOnlySize;
+	if(!twiRegisterMapActive || (reg >= TWI_SLAVE_READ_WRITE_SIZE)) {
+		return FALSE;
+	}
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		*value = twiReadWriteBuffer[reg];
+		if(isBitSet(twiReadWriteDirty[reg >> 3], reg & 7)) {
+			clrBit(twiReadWriteDirty[reg >> 3], reg & 7);
+			dirty = TRUE;
+		}
+	}
+
+	return dirty;
+}
+
+// Sets the value of a read-write register (map address) seen by the master.
+// Does nothing if the register map is not active (raw buffer mode)
+void twiSlaveSetRegister(uint8 reg, uint8 value)
+{
+	reg -= twiReadOnlySize;
+	if(twiRegisterMapActive && (reg < TWI_SLAVE_READ_WRITE_SIZE)) {
+		twiReadWriteBuffer[reg] = value;
+	}
+}
+#endif
+
+// -----------------------------------------------------------------------------
+// Private function definitions ------------------------------------------------
+
+static void twiSlaveEnable(uint8 twiSlaveAddr, bool_t genCallAcceptance)
+{
+	twiBufferIndex = 0;
+#ifdef TWI_SLAVE_REGISTER_MAP
+	twiWriteCount = 0;
+#endif
+	twiBusy = 0;
 	TWAR = (twiSlaveAddr << 1) | (genCallAcceptance & 1);
 	TWCR =	(1 << TWEN) |
 			(1 << TWIE) | (1 << TWINT) |
 			(1 << TWEA) | (0 << TWSTA) | (0 << TWSTO) |
 			(0 << TWWC);
-	twiBusy = 0;
+}
 
-	twiBufferData = (twiBuffer_t *)calloc(bufferSize, sizeof(uint8));
+static uint8 twiSlaveReadMap(uint8 reg)
+{
+#ifdef TWI_SLAVE_REGISTER_MAP
+	if(reg < twiReadOnlySize) {
+		return twiReadOnlyBuffer[twiReadOnlyFront][reg];
+	}
+	reg -= twiReadOnlySize;
+#endif
+	if(reg < twiBufferSize) {
+		return twiBufferData[reg];
+	}
 
-	if(twiBufferData == NULL) {
-		return NULL;
+	return 0xFF;
+}
+
+static bool_t twiSlaveWriteMap(uint8 reg, uint8 data)
+{
+#ifdef TWI_SLAVE_REGISTER_MAP
+	if(reg < twiReadOnlySize) {
+		return FALSE;
+	}
+	reg -= twiReadOnlySize;
+#endif
+	if(reg >= twiBufferSize) {
+		return FALSE;
 	}
 
-	twiBufferSize = bufferSize;
+	twiBufferData[reg] = data;
+#ifdef TWI_SLAVE_REGISTER_MAP
+	if(twiRegisterMapActive) {
+		setBit(twiReadWriteDirty[reg >> 3], reg & 7);
+	}
+#endif
 
-	return twiBufferData;
+	return TRUE;
+}
+
+// Auto-increment of the register pointer; past the end of the map the pointer
+// is parked at the map size. The raw buffer always wraps to 0
+static uint8 twiSlaveNextRegister(uint8 reg)
+{
+#ifdef TWI_SLAVE_REGISTER_MAP
+	uint8 mapSize = twiReadOnlySize + twiBufferSize;
+
+	if(reg >= mapSize) {
+		return mapSize;
+	}
+	reg++;
+
+	switch(twiWrap) {
+	case TWI_SLAVE_WRAP_REGION:
+		if(reg == twiReadOnlySize) {
+			return 0;
+		}
+		if(reg == mapSize) {
+			return twiReadOnlySize;
+		}
+		break;
+	case TWI_SLAVE_WRAP_MAP:
+		if(reg == mapSize) {
+			return 0;
+		}
+		break;
+	case TWI_SLAVE_WRAP_NONE:
+		break;
+	}
+
+	return reg;
+#else
+	if(reg >= twiBufferSize) {
+		return twiBufferSize;
+	}
+	reg++;
+
+	return (reg == twiBufferSize) ? 0 : reg;
+#endif
+}
+
+#ifdef TWI_SLAVE_REGISTER_MAP
+// Publishes the read-only region as a whole, on an address match
+static void twiSlaveSwapReadOnly(void)
+{
+	if(twiReadOnlyReady) {
+		twiReadOnlyFront ^= 1;
+		twiReadOnlyReady = FALSE;
+		twiReadOnlySwapped = TRUE;
+	}
+}
+
+// Accounts a stored register. A register that does not follow the current run
+// (auto-increment wrap or skipped read-only registers) reports the run first,
+// so the callback always receives contiguous ranges
+static void twiSlaveWriteRun(uint8 reg)
+{
+	if((twiWriteCount != 0) && ((uint16)twiWriteFirst + twiWriteCount != reg)) {
+		twiSlaveWriteReport();
+	}
+	if(twiWriteCount == 0) {
+		twiWriteFirst = reg;
+	}
+	twiWriteCount++;
+}
+
+static void twiSlaveWriteReport(void)
+{
+	if((twiWriteCount != 0) && (twiWriteCallback != NULL)) {
+		twiWriteCallback(twiWriteFirst, twiWriteCount);
+	}
+	twiWriteCount = 0;
 }
+#endif
+
+// -----------------------------------------------------------------------------
+// Interruption handlers -------------------------------------------------------
 
 ISR(TWI_vect)
 {
-	switch (TWSR) {
+	uint8 status = TWSR & 0xF8;
+
+	switch (status) {
 	case TWI_STX_ADR_ACK:
+#ifdef TWI_SLAVE_REGISTER_MAP
+		twiSlaveSwapReadOnly();
+#endif
+		// fall through
 	case TWI_STX_DATA_ACK:
-		TWDR = twiBufferData[twiBufferIndex++];
-
-		if(twiBufferIndex >= twiBufferSize) {
-			twiBufferIndex = 0;
-		}
+		TWDR = twiSlaveReadMap(twiBufferIndex);
+		twiBufferIndex = twiSlaveNextRegister(twiBufferIndex);
 
 		TWCR =	(1 << TWEN) |
 				(1 << TWIE) | (1 << TWINT) |
@@ -77,6 +325,10 @@ ISR(TWI_vect)
 
 	case TWI_SRX_GEN_ACK:
 	case TWI_SRX_ADR_ACK:
+#ifdef TWI_SLAVE_REGISTER_MAP
+		twiSlaveSwapReadOnly();
+		twiWriteCount = 0;
+#endif
 		TWCR =	(1 << TWEN) |
 				(1 << TWIE) | (1 << TWINT) |
 				(1 << TWEA) | (0 << TWSTA) | (0 << TWSTO) |
@@ -92,11 +344,14 @@ ISR(TWI_vect)
 			twiBufferIndex = TWDR;
 		}
 		else {
-			twiBufferIndex++;
-
-			if(twiBufferIndex >= twiBufferSize) {
-				twiBufferIndex = 0;
+#ifdef TWI_SLAVE_REGISTER_MAP
+			if(twiSlaveWriteMap(twiBufferIndex, TWDR)) {
+				twiSlaveWriteRun(twiBufferIndex);
 			}
+#else
+			twiSlaveWriteMap(twiBufferIndex, TWDR);
+#endif
+			twiBufferIndex = twiSlaveNextRegister(twiBufferIndex);
 		}
 
 		TWCR =	(1 << TWEN) |
@@ -111,17 +366,23 @@ ISR(TWI_vect)
 				(1 << TWIE) | (1 << TWINT) |
 				(1 << TWEA) | (0 << TWSTA) | (0 << TWSTO) |
 				(0 << TWWC);
+#ifdef TWI_SLAVE_REGISTER_MAP
+		twiSlaveWriteReport();
+#endif
 		twiBusy = 0;
 		break;
 
 	case TWI_SRX_ADR_DATA_NACK:
 	case TWI_SRX_GEN_DATA_NACK:
 	case TWI_STX_DATA_ACK_LAST_BYTE:
-	case TWI_BUS_ERROR:
-		TWCR =	(0 << TWEN) |
-				(0 << TWIE) | (1 << TWINT) |
-				(0 << TWEA) | (0 << TWSTA) | (1 << TWSTO) |
+	case TWI_BUS_ERROR:				// Releases the lines and stays addressable
+		TWCR =	(1 << TWEN) |
+				(1 << TWIE) | (1 << TWINT) |
+				(1 << TWEA) | (0 << TWSTA) | (1 << TWSTO) |
 				(0 << TWWC);
+#ifdef TWI_SLAVE_REGISTER_MAP
+		twiWriteCount = 0;
+#endif
 		twiBusy = 0;
 
 		break;
@@ -5,8 +5,10 @@
  * Author:			Leandro Schwarz
  *					Hazael dos Santos Batista
  * Build:			1
- * Last edition:	September 18, 2017
- * Purpose:			Interfaces a TWI Slave data bus
+ * Last edition:	October 17, 2026
+ * Purpose:			Interfaces a TWI Slave data bus, either as a raw buffer or as
+ *					a register map with a double-buffered read-only region and
+ *					a read-write region
  * -------------------------------------------------------------------------- */
 
 #ifndef __TWI_SLAVE_H
@@ -21,6 +23,24 @@
 #endif
 #include <stdlib.h>
 
+// -----------------------------------------------------------------------------
+// Constant definitions --------------------------------------------------------
+
+// Define TWI_SLAVE_REGISTER_MAP to build the register map mode
+// (twiSlaveRegisterMapInit() and related functions). Its storage takes
+// 2 * TWI_SLAVE_READ_ONLY_SIZE + TWI_SLAVE_READ_WRITE_SIZE bytes plus the dirty
+// bitmap. Read-only registers start at address 0, followed by the read-write
+// registers.
+#ifdef TWI_SLAVE_REGISTER_MAP
+	#ifndef TWI_SLAVE_READ_ONLY_SIZE
+		#define TWI_SLAVE_READ_ONLY_SIZE	16
+	#endif
+	#ifndef TWI_SLAVE_READ_WRITE_SIZE
+		#define TWI_SLAVE_READ_WRITE_SIZE	16
+	#endif
+	_Static_assert((TWI_SLAVE_READ_ONLY_SIZE + TWI_SLAVE_READ_WRITE_SIZE) < 256, "TWI slave register map must have less than 256 registers");
+#endif
+
 // -----------------------------------------------------------------------------
 // New data types --------------------------------------------------------------
 
@@ -41,9 +61,28 @@ typedef enum twiSlaveState_t {
 	TWI_BUS_ERROR				= 0x00
 } twiSlaveState_t;
 
+typedef enum twiSlaveWrap_t {
+	TWI_SLAVE_WRAP_MAP			= 0,	// Auto-increment wraps from the last register to 0
+	TWI_SLAVE_WRAP_REGION		= 1,	// Auto-increment wraps inside the current region
+	TWI_SLAVE_WRAP_NONE			= 2		// Stops at the end (reads 0xFF, writes ignored)
+} twiSlaveWrap_t;
+
+// Called from the interruption at the end of a write transaction with the
+// first register stored and the number of consecutive registers stored. A
+// transaction whose stored registers are not contiguous (auto-increment wrap)
+// is reported as several calls
+typedef void (* twiSlaveWriteCallback_t)(uint8 firstRegister, uint8 count);
+
 // -----------------------------------------------------------------------------
 // Public functions declaration ------------------------------------------------
 
-twiBuffer_t * twiSlaveInit(uint8 twiSlaveAddr, uint8 bufferSize, bool_t genCallAcceptance);
+twiBuffer_t *	twiSlaveInit(uint8 twiSlaveAddr, uint8 bufferSize, bool_t genCallAcceptance);
+#ifdef TWI_SLAVE_REGISTER_MAP
+void			twiSlaveRegisterMapInit(uint8 twiSlaveAddr, twiSlaveWrap_t wrap, twiSlaveWriteCallback_t callback, bool_t genCallAcceptance);
+uint8 *			twiSlaveBeginUpdate(void);
+void			twiSlaveEndUpdate(void);
+bool_t			twiSlaveGetRegister(uint8 reg, uint8 * value);
+void			twiSlaveSetRegister(uint8 reg, uint8 value);
+#endif
 
 #endif
@@ -0,0 +1,364 @@
+/* -----------------------------------------------------------------------------
+ * Project:			GPDSE AVR8 Library
+ * File:			twiSoftMaster.c
+ * Module:			Two Wire Interface software master controller
+ * Author:			Leandro Schwarz
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			Bit-banged TWI (I2C) master on any pair of GPIO pins of the
+ *					same port, to be used as a second bus besides twiMaster.
+ *					The lines are driven as open-drain outputs by toggling the
+ *					DDR bits (external pull-ups are required), and clock
+ *					stretching is supported. The pins and the bus speed are
+ *					selected at compile time
+ * -------------------------------------------------------------------------- */
+
+// -----------------------------------------------------------------------------
+// Header files ----------------------------------------------------------------
+
+#include "twiSoftMaster.h"
+#if __TWISOFTMASTER_H != 1
+	#error Error 101 - Build mismatch on header and source code files (twiSoftMaster).
+#endif
+
+// -----------------------------------------------------------------------------
+// Macrofunctions --------------------------------------------------------------
+
+#define twiSoftSdaLow()					setBit(TWI_SOFT_DDR, TWI_SOFT_SDA)
+#define twiSoftSdaRelease()				clrBit(TWI_SOFT_DDR, TWI_SOFT_SDA)
+#define twiSoftSclLow()					setBit(TWI_SOFT_DDR, TWI_SOFT_SCL)
+#define twiSoftSdaIsHigh()				isBitSet(TWI_SOFT_PIN, TWI_SOFT_SDA)
+#define twiSoftDelay()					__builtin_avr_delay_cycles(TWI_SOFT_HALF_PERIOD_CYCLES)
+
+// -----------------------------------------------------------------------------
+// Private functions declaration -----------------------------------------------
+
+static bool_t		twiSoftMasterSclRelease(void);
+static twiResult_t	twiSoftMasterFreeBus(void);
+static twiResult_t	twiSoftMasterStart(uint8 deviceAddress, uint8 readWrite, bool_t repeated);
+static void			twiSoftMasterStop(void);
+static twiResult_t	twiSoftMasterWriteByte(uint8 data);
+static twiResult_t	twiSoftMasterReadByte(uint8 * data, bool_t acknowledge);
+static twiResult_t	twiSoftMasterTransmit(const uint8 * message, uint16 messageSize);
+static twiResult_t	twiSoftMasterReceive(uint8 * message, uint16 messageSize);
+
+// -----------------------------------------------------------------------------
+// Public function definitions -------------------------------------------------
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiSoftMasterInit
+ * Purpose:		Configures the pins as released open-drain lines
+ * Arguments:	none
+ * Returns:		TWI_OK or TWI_BUS_HANG_ERROR if a line is held low
+ * -------------------------------------------------------------------------- */
+
+twiResult_t twiSoftMasterInit(void)
+{
+	twiSoftSdaRelease();
+	clrBit(TWI_SOFT_DDR, TWI_SOFT_SCL);
+	clrBit(TWI_SOFT_PORT, TWI_SOFT_SDA);	// Pulled low when DDR = 1
+	clrBit(TWI_SOFT_PORT, TWI_SOFT_SCL);
+	twiSoftDelay();
+
+	if(!twiSoftSdaIsHigh() || isBitClr(TWI_SOFT_PIN, TWI_SOFT_SCL))
+		return TWI_BUS_HANG_ERROR;
+	return TWI_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiSoftMasterWrite
+ * Purpose:		Sends data from master to slave device
+ * Arguments:	deviceAddress		Bus address of the slave device
+ * 				message				message to be transmitted
+ * 				messageSize			number of bytes to be sent
+ * Returns:		TWI_OK, TWI_TRANSFER_ERROR (NACK), TWI_TIMEOUT_ERROR or
+ * 				TWI_BUS_HANG_ERROR
+ * -------------------------------------------------------------------------- */
+
+twiResult_t twiSoftMasterWrite(uint8 deviceAddress, const uint8 * message, uint16 messageSize)
+{
+	twiResult_t result;
+
+	result = twiSoftMasterStart(deviceAddress, TWI_MASTER_WRITE, FALSE);
+	if(result == TWI_OK)
+		result = twiSoftMasterTransmit(message, messageSize);
+	if((result == TWI_OK) || (result == TWI_TRANSFER_ERROR))
+		twiSoftMasterStop();
+
+	return result;
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiSoftMasterRead
+ * Purpose:		Reads data from a slave device
+ * Arguments:	deviceAddress		Bus address of the slave device
+ * 				message				buffer for the received data
+ * 				messageSize			number of bytes to be read
+ * Returns:		TWI_OK, TWI_TRANSFER_ERROR (NACK), TWI_TIMEOUT_ERROR or
+ * 				TWI_BUS_HANG_ERROR
+ * -------------------------------------------------------------------------- */
+
+twiResult_t twiSoftMasterRead(uint8 deviceAddress, uint8 * message, uint16 messageSize)
+{
+	twiResult_t result;
+
+	result = twiSoftMasterStart(deviceAddress, TWI_MASTER_READ, FALSE);
+	if(result == TWI_OK)
+		result = twiSoftMasterReceive(message, messageSize);
+	if((result == TWI_OK) || (result == TWI_TRANSFER_ERROR))
+		twiSoftMasterStop();
+
+	return result;
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiSoftMasterWriteRead
+ * Purpose:		Writes data to a slave device and reads its answer after a
+ * 				repeated START (e.g. register reads)
+ * Arguments:	deviceAddress		Bus address of the slave device
+ * 				txMessage			data to be sent (e.g. register address)
+ * 				txSize				number of bytes to be sent
+ * 				rxMessage			buffer for the received data
+ * 				rxSize				number of bytes to be read
+ * Returns:		TWI_OK, TWI_TRANSFER_ERROR (NACK), TWI_TIMEOUT_ERROR or
+ * 				TWI_BUS_HANG_ERROR
+ * -------------------------------------------------------------------------- */
+
+twiResult_t twiSoftMasterWriteRead(uint8 deviceAddress, const uint8 * txMessage, uint16 txSize, uint8 * rxMessage, uint16 rxSize)
+{
+	twiResult_t result;
+
+	result = twiSoftMasterStart(deviceAddress, TWI_MASTER_WRITE, FALSE);
+	if(result == TWI_OK)
+		result = twiSoftMasterTransmit(txMessage, txSize);
+	if(result == TWI_OK)
+		result = twiSoftMasterStart(deviceAddress, TWI_MASTER_READ, TRUE);
+	if(result == TWI_OK)
+		result = twiSoftMasterReceive(rxMessage, rxSize);
+	if((result == TWI_OK) || (result == TWI_TRANSFER_ERROR))
+		twiSoftMasterStop();
+
+	return result;
+}
+
+// -----------------------------------------------------------------------------
+// Private function definitions ------------------------------------------------
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiSoftMasterSclRelease
+ * Purpose:		Releases SCL and waits while a slave stretches the clock
+ * Arguments:	none
+ * Returns:		TRUE, or FALSE if SCL is held low longer than
+ * 				TWI_SOFT_STRETCH_TIMEOUT half periods (both lines are released)
+ * -------------------------------------------------------------------------- */
+
+static bool_t twiSoftMasterSclRelease(void)
+{
+	uint16 i;
+
+	clrBit(TWI_SOFT_DDR, TWI_SOFT_SCL);
+	for(i = 0;isBitClr(TWI_SOFT_PIN, TWI_SOFT_SCL);i++){
+		if(i == TWI_SOFT_STRETCH_TIMEOUT){
+			twiSoftSdaRelease();
+			return FALSE;
+		}
+		twiSoftDelay();
+	}
+	return TRUE;
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiSoftMasterFreeBus
+ * Purpose:		Checks that both lines are released before a START. If a slave
+ * 				left mid-byte (e.g. after a timeout) holds SDA low, clocks up to
+ * 				9 pulses on SCL until SDA is released and sends a STOP
+ * Arguments:	none
+ * Returns:		TWI_OK or TWI_BUS_HANG_ERROR if a line is still held low
+ * -------------------------------------------------------------------------- */
+
+static twiResult_t twiSoftMasterFreeBus(void)
+{
+	uint8 i;
+
+	if(twiSoftSdaIsHigh() && isBitSet(TWI_SOFT_PIN, TWI_SOFT_SCL))
+		return TWI_OK;
+
+	twiSoftSdaRelease();
+	if(!twiSoftMasterSclRelease())
+		return TWI_BUS_HANG_ERROR;
+	for(i = 0;(i < 9) && !twiSoftSdaIsHigh();i++){
+		twiSoftSclLow();
+		twiSoftDelay();
+		if(!twiSoftMasterSclRelease())
+			return TWI_BUS_HANG_ERROR;
+		twiSoftDelay();
+	}
+	if(!twiSoftSdaIsHigh())
+		return TWI_BUS_HANG_ERROR;
+
+	twiSoftSclLow();
+	twiSoftDelay();
+	twiSoftMasterStop();
+
+	return TWI_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiSoftMasterStart
+ * Purpose:		Generates a START (or repeated START) condition and sends the
+ * 				address of the slave device
+ * Arguments:	deviceAddress		Bus address of the slave device
+ * 				readWrite			TWI_MASTER_READ or TWI_MASTER_WRITE
+ * 				repeated			TRUE for a repeated START
+ * Returns:		TWI_OK, TWI_TRANSFER_ERROR (NACK), TWI_TIMEOUT_ERROR or
+ * 				TWI_BUS_HANG_ERROR
+ * -------------------------------------------------------------------------- */
+
+static twiResult_t twiSoftMasterStart(uint8 deviceAddress, uint8 readWrite, bool_t repeated)
+{
+	twiResult_t result;
+
+	if(repeated){					// SCL is low after the last ACK
+		twiSoftSdaRelease();
+		twiSoftDelay();
+		if(!twiSoftMasterSclRelease())
+			return TWI_TIMEOUT_ERROR;
+		twiSoftDelay();
+	}else{
+		result = twiSoftMasterFreeBus();
+		if(result != TWI_OK)
+			return result;
+	}
+	twiSoftSdaLow();				// SDA falls while SCL is high
+	twiSoftDelay();
+	twiSoftSclLow();
+
+	return twiSoftMasterWriteByte((deviceAddress << 1) | readWrite);
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiSoftMasterStop
+ * Purpose:		Generates a STOP condition
+ * Arguments:	none
+ * Returns:		none
+ * -------------------------------------------------------------------------- */
+
+static void twiSoftMasterStop(void)
+{
+	twiSoftSdaLow();
+	twiSoftDelay();
+	twiSoftMasterSclRelease();
+	twiSoftDelay();
+	twiSoftSdaRelease();			// SDA rises while SCL is high
+	twiSoftDelay();
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiSoftMasterWriteByte
+ * Purpose:		Shifts out a byte, MSB first, and reads the acknowledge bit
+ * Arguments:	data				byte to be sent
+ * Returns:		TWI_OK, TWI_TRANSFER_ERROR (NACK) or TWI_TIMEOUT_ERROR
+ * -------------------------------------------------------------------------- */
+
+static twiResult_t twiSoftMasterWriteByte(uint8 data)
+{
+	uint8 i;
+	bool_t acknowledge;
+
+	for(i = 0;i < 8;i++){
+		if(data & 0x80)
+			twiSoftSdaRelease();
+		else
+			twiSoftSdaLow();
+		data <<= 1;
+		twiSoftDelay();
+		if(!twiSoftMasterSclRelease())
+			return TWI_TIMEOUT_ERROR;
+		twiSoftDelay();
+		twiSoftSclLow();
+	}
+
+	twiSoftSdaRelease();			// Acknowledge bit
+	twiSoftDelay();
+	if(!twiSoftMasterSclRelease())
+		return TWI_TIMEOUT_ERROR;
+	twiSoftDelay();
+	acknowledge = !twiSoftSdaIsHigh();
+	twiSoftSclLow();
+
+	return acknowledge ? TWI_OK : TWI_TRANSFER_ERROR;
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiSoftMasterReadByte
+ * Purpose:		Shifts in a byte, MSB first, and sends the acknowledge bit
+ * Arguments:	data				pointer to where the byte must be stored
+ * 				acknowledge			TRUE to ACK, FALSE to NACK (last byte)
+ * Returns:		TWI_OK or TWI_TIMEOUT_ERROR
+ * -------------------------------------------------------------------------- */
+
+static twiResult_t twiSoftMasterReadByte(uint8 * data, bool_t acknowledge)
+{
+	uint8 i;
+	uint8 aux8 = 0;
+
+	twiSoftSdaRelease();
+	for(i = 0;i < 8;i++){
+		twiSoftDelay();
+		if(!twiSoftMasterSclRelease())
+			return TWI_TIMEOUT_ERROR;
+		twiSoftDelay();
+		aux8 = (aux8 << 1) | (twiSoftSdaIsHigh() ? 1 : 0);
+		twiSoftSclLow();
+	}
+	*data = aux8;
+
+	if(acknowledge)					// Acknowledge bit
+		twiSoftSdaLow();
+	twiSoftDelay();
+	if(!twiSoftMasterSclRelease())
+		return TWI_TIMEOUT_ERROR;
+	twiSoftDelay();
+	twiSoftSclLow();
+	twiSoftSdaRelease();
+
+	return TWI_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiSoftMasterTransmit
+ * Purpose:		Sends the data bytes of a write transaction
+ * Arguments:	message				data to be sent
+ * 				messageSize			number of bytes
+ * Returns:		TWI_OK, TWI_TRANSFER_ERROR (NACK) or TWI_TIMEOUT_ERROR
+ * -------------------------------------------------------------------------- */
+
+static twiResult_t twiSoftMasterTransmit(const uint8 * message, uint16 messageSize)
+{
+	twiResult_t result = TWI_OK;
+	uint16 i;
+
+	for(i = 0;(i < messageSize) && (result == TWI_OK);i++)
+		result = twiSoftMasterWriteByte(message[i]);
+
+	return result;
+}
+
+/* -----------------------------------------------------------------------------
+ * Function:	twiSoftMasterReceive
+ * Purpose:		Receives the data bytes of a read transaction, NACKing the last
+ * Arguments:	message				buffer for the received data
+ * 				messageSize			number of bytes
+ * Returns:		TWI_OK or TWI_TIMEOUT_ERROR
+ * -------------------------------------------------------------------------- */
+
+static twiResult_t twiSoftMasterReceive(uint8 * message, uint16 messageSize)
+{
+	twiResult_t result = TWI_OK;
+	uint16 i;
+
+	for(i = 0;(i < messageSize) && (result == TWI_OK);i++)
+		result = twiSoftMasterReadByte(&message[i], (i + 1) < messageSize);
+
+	return result;
+}
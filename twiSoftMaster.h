@@ -0,0 +1,69 @@
+/* -----------------------------------------------------------------------------
+ * Project:			GPDSE AVR8 Library
+ * File:			twiSoftMaster.h
+ * Module:			Two Wire Interface software master controller
+ * Author:			Leandro Schwarz
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			Bit-banged TWI (I2C) master on any pair of GPIO pins of the
+ *					same port, to be used as a second bus besides twiMaster.
+ *					The lines are driven as open-drain outputs by toggling the
+ *					DDR bits (external pull-ups are required), and clock
+ *					stretching is supported. The pins and the bus speed are
+ *					selected at compile time
+ * -------------------------------------------------------------------------- */
+
+#ifndef __TWISOFTMASTER_H
+#define __TWISOFTMASTER_H 1
+
+// -----------------------------------------------------------------------------
+// Header files ----------------------------------------------------------------
+
+#include "globalDefines.h"
+#if __GLOBALDEFINES_H != 1
+	#error Error 100 - globalDefines.h - wrong build (globalDefines must be build 1).
+#endif
+#include "twiMaster.h"
+#if __TWIMASTER_H != 1
+	#error Error 100 - twiMaster.h - wrong build (twiMaster must be build 1).
+#endif
+
+// -----------------------------------------------------------------------------
+// Constant definitions --------------------------------------------------------
+
+// The pins are given by TWI_SOFT_DDR, TWI_SOFT_PORT, TWI_SOFT_PIN, TWI_SOFT_SDA
+// and TWI_SOFT_SCL; either all of them or none must be defined
+#if !defined(TWI_SOFT_DDR) && !defined(TWI_SOFT_PORT) && !defined(TWI_SOFT_PIN) && !defined(TWI_SOFT_SDA) && !defined(TWI_SOFT_SCL)
+	#define TWI_SOFT_DDR				DDRC
+	#define TWI_SOFT_PORT				PORTC
+	#define TWI_SOFT_PIN				PINC
+	#define TWI_SOFT_SDA				PC2
+	#define TWI_SOFT_SCL				PC3
+#elif !defined(TWI_SOFT_DDR) || !defined(TWI_SOFT_PORT) || !defined(TWI_SOFT_PIN) || !defined(TWI_SOFT_SDA) || !defined(TWI_SOFT_SCL)
+	#error Error 106 - twiSoftMaster.h - TWI_SOFT_DDR, TWI_SOFT_PORT, TWI_SOFT_PIN, TWI_SOFT_SDA and TWI_SOFT_SCL must be defined together.
+#endif
+// SCL frequency, up to 400 kHz at 16 MHz
+#ifndef TWI_SOFT_CLOCK_SPEED
+	#define TWI_SOFT_CLOCK_SPEED		100000UL
+#endif
+// Maximum number of half clock periods a slave may stretch SCL
+#ifndef TWI_SOFT_STRETCH_TIMEOUT
+	#define TWI_SOFT_STRETCH_TIMEOUT	1000
+#endif
+
+// Cycles spent by the code between two delays of a half clock period
+#define TWI_SOFT_OVERHEAD_CYCLES		8
+#define TWI_SOFT_HALF_PERIOD_CYCLES		((F_CPU / (2UL * (TWI_SOFT_CLOCK_SPEED))) - TWI_SOFT_OVERHEAD_CYCLES)
+#if (TWI_SOFT_CLOCK_SPEED > 400000UL) || ((F_CPU / (2UL * (TWI_SOFT_CLOCK_SPEED))) <= TWI_SOFT_OVERHEAD_CYCLES)
+	#error Error 105 - twiSoftMaster.h - TWI_SOFT_CLOCK_SPEED cannot be generated from F_CPU.
+#endif
+
+// -----------------------------------------------------------------------------
+// Public functions declaration ------------------------------------------------
+
+twiResult_t	twiSoftMasterInit(void);
+twiResult_t	twiSoftMasterWrite(uint8 deviceAddress, const uint8 * message, uint16 messageSize);
+twiResult_t	twiSoftMasterRead(uint8 deviceAddress, uint8 * message, uint16 messageSize);
+twiResult_t	twiSoftMasterWriteRead(uint8 deviceAddress, const uint8 * txMessage, uint16 txSize, uint8 * rxMessage, uint16 rxSize);
+
+#endif
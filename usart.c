@@ -3,8 +3,10 @@
  * File:			usart.c
  * Module:			USART interface
  * Author:			Leandro Schwarz
- * Version:			13.0
- * Last edition:	2017-06-17
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			USART0 controller, with optional interrupt-driven ring
+ *					buffers (USART_BUFFERED_MODE)
  * -------------------------------------------------------------------------- */
 
 // -----------------------------------------------------------------------------
@@ -14,11 +16,67 @@
 #if __USART_H != 1
 	#error Error 101 - Build mismatch on header and source code files (usart).
 #endif
+#ifdef USART_BUFFERED_MODE
+	#include "circularBuffer.h"
+	#if __CIRCULAR_BUFFER_H != 1
+		#error Error 100 - circularBuffer.h - wrong build (circularBuffer must be build 1).
+	#endif
+	#include <util/atomic.h>
+#endif
+#ifdef USART_AUTO_BAUD
+	#include "timer1.h"
+	#if __TIMER1_H != 1
+		#error Error 100 - timer1.h - wrong build (timer1 must be build 1).
+	#endif
+#endif
+
+// -----------------------------------------------------------------------------
+// Constant definitions --------------------------------------------------------
+
+#define USART_SLIP_END					0xC0
+#define USART_SLIP_ESC					0xDB
+#define USART_SLIP_ESC_END				0xDC
+#define USART_SLIP_ESC_ESC				0xDD
 
 // -----------------------------------------------------------------------------
 // Global variables ------------------------------------------------------------
 
 FILE usartStream = FDEV_SETUP_STREAM(usartTransmitStd, usartReceiveStd, _FDEV_SETUP_RW);
+#ifdef USART_BUFFERED_MODE
+createStaticCircularBufferSpsc(usartRxBuffer, uint8, USART_RX_BUFFER_SIZE)
+createStaticCircularBufferSpsc(usartTxBuffer, uint8, USART_TX_BUFFER_SIZE)
+FILE usartBufferedStream = FDEV_SETUP_STREAM(usartTransmitBufferedStd, usartReceiveBufferedStd, _FDEV_SETUP_RW);
+static usartTxFullPolicy_t usartTxFullPolicy = USART_TX_FULL_BLOCK;
+static bool_t usartTxTruncating = FALSE;
+static uint16 usartDroppedBytes = 0;
+static bool_t usartMultiprocessorMode = FALSE;
+static uint8 usartNodeAddress = 0;
+static usartFraming_t usartFraming = USART_FRAMING_NONE;
+static uint8 usartFrameBuffer[2][USART_FRAME_SIZE];
+static volatile uint8 usartFrameWriting = 0;		// Buffer being filled by the ISR
+static uint8 usartFrameLength = 0;
+static bool_t usartFrameDiscarding = FALSE;		// Frame too long, waits for the end
+static bool_t usartFrameEscape = FALSE;			// SLIP escape received
+static volatile bool_t usartFrameReady = FALSE;
+static volatile uint8 usartFrameReadyLength = 0;
+static volatile uint16 usartDroppedFrames = 0;
+static volatile usartStatistics_t usartStatistics = {0, 0, 0, 0};
+static vuint8 * volatile usartRs485Port = NULL;
+static uint8 usartRs485Bit = 0;
+static vuint8 * volatile usartRtsPort = NULL;
+static uint8 usartRtsBit = 0;
+static vuint8 * volatile usartCtsPin = NULL;
+static uint8 usartCtsBit = 0;
+static volatile usartReceptionCallback_t usartReceptionCallback = NULL;
+#endif
+
+// -----------------------------------------------------------------------------
+// Private functions declaration -----------------------------------------------
+
+#ifdef USART_BUFFERED_MODE
+static void usartStartTransmission(void);
+static void usartRtsUpdate(void);
+#endif
 
 /* -----------------------------------------------------------------------------
  * Configures the USART controller
@@ -31,7 +89,9 @@ resultValue_t usartConfig(usartMode_t mode, usartBaudRate_t baudRate, usartDataB
 	uint8 reg3 = UCSR0C;
 	uint8 modeAux = 0;
 	uint8 aux8 = 0;
-	uint64 aux64 = 0;
+	uint32 divisor = 0;
+	uint32 ubrr = 0;
+	uint32 aux32 = 0;
 
 	// Clear errors
 	reg1 &= ~((1 << FE0) | (1 << DOR0) | (1 << UPE0));
@@ -136,28 +196,199 @@ resultValue_t usartConfig(usartMode_t mode, usartBaudRate_t baudRate, usartDataB
 	if(baudRate != USART_BAUD_NO_CHANGE) {
 		switch(modeAux) {
 		case USART_MODE_ASYNCHRONOUS:
-			aux64 = (F_CPU / 16 / baudRate) - 1;
+			divisor = 16;
 			break;
 		case USART_MODE_ASYNCHRONOUS_DOUBLE_SPEED:
-			aux64 = (F_CPU / 8 / baudRate) - 1;
+			divisor = 8;
 			break;
-		case USART_MODE_SYNCHRONOUS_SPI:
-			aux64 = (F_CPU / 2 / baudRate) - 1;
+		default:		// Synchronous modes
+			divisor = 2;
 			break;
 		}
-		//		if((aux64 > (1.05 * baudRate)) || (aux64 < (0.95 * baudRate)))
-		//			return RESULT_UNSUPPORTED_USART_BAUD_RATE;
+		// UBRR = F_CPU / (divisor * baudRate) - 1, rounded to the nearest value
+		aux32 = divisor * (uint32)baudRate;
+		ubrr = ((uint32)F_CPU + (aux32 / 2)) / aux32;
+		if((ubrr == 0) || (ubrr > 4096))
+			return RESULT_UNSUPPORTED_USART_BAUD_RATE;
+		// Asynchronous modes must be within USART_BAUD_RATE_TOLERANCE
+		if(divisor != 2) {
+			aux32 *= ubrr;
+			aux32 = (aux32 > (uint32)F_CPU) ? (aux32 - (uint32)F_CPU) : ((uint32)F_CPU - aux32);
+			if((aux32 * 100) > ((uint32)F_CPU * USART_BAUD_RATE_TOLERANCE))
+				return RESULT_UNSUPPORTED_USART_BAUD_RATE;
+		}
+		ubrr--;
 	}
 
 	UCSR0A = reg1;
 	UCSR0B = reg2;
 	UCSR0C = reg3;
-	UBRR0H = (uint8)(0x0F & (aux64 >> 8));
-	UBRR0L = (uint8)(0xFF & aux64);
+	if(baudRate != USART_BAUD_NO_CHANGE) {
+		UBRR0H = (uint8)(0x0F & (ubrr >> 8));
+		UBRR0L = (uint8)(0xFF & ubrr);
+	}
 
 	return RESULT_OK;
 }
 
+#ifdef USART_BAUD_RATE
+/* -----------------------------------------------------------------------------
+ * Sets the baud rate defined by USART_BAUD_RATE, using the UBRR0 value and the
+ * double speed selection computed at compile time. Must be called after
+ * usartConfig() in asynchronous mode (with USART_BAUD_NO_CHANGE)
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartSetConstantBaudRate(void)
+{
+	UBRR0H = (uint8)(0x0F & (USART_UBRR_VALUE >> 8));
+	UBRR0L = (uint8)(0xFF & USART_UBRR_VALUE);
+#if USART_USE_DOUBLE_SPEED == 1
+	setBit(UCSR0A, U2X0);
+#else
+	clrBit(UCSR0A, U2X0);
+#endif
+
+	return RESULT_OK;
+}
+#endif
+
+#ifdef USART_AUTO_BAUD
+/* -----------------------------------------------------------------------------
+ * Measures the bit time of a sync character received after an idle line and
+ * sets UBRR0 and U2X0 to the closest baud rate. The 0x55 ('U') character is
+ * recommended, since every bit boundary produces an edge. The RXD pin must
+ * also be wired to the timer1 input capture pin (ICP1), which timestamps the
+ * edges. Timer1 is borrowed while the function runs: its configuration is
+ * restored at the end, but the counter value is lost. The interruptions are
+ * disabled from the start bit until the end of the character. Returns
+ * RESULT_UNSUPPORTED_USART_BAUD_RATE if no character is received within
+ * timeout milliseconds or if the measured rate cannot be generated within
+ * USART_BAUD_RATE_TOLERANCE
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartAutoBaud(uint16 timeout)
+{
+	uint8 tccr1a = TCCR1A;
+	uint8 tccr1b = TCCR1B;
+	uint8 timsk1 = TIMSK1;
+	uint8 sreg;
+	uint32 overflows = (((uint32)timeout * (F_CPU / 1000UL)) >> 16) + 1;
+	uint16 intervals[USART_AUTO_BAUD_EDGES];
+	uint16 minimum = 0xFFFF;
+	uint16 limit = 0xF000;
+	uint16 last;
+	uint16 aux16;
+	uint8 edges = 0;
+	uint8 i;
+	uint32 span = 0;
+	uint32 bits = 0;
+	uint32 ubrrSingle;
+	uint32 ubrrDouble;
+	uint32 errorSingle = 0xFFFFFFFFUL;
+	uint32 errorDouble = 0xFFFFFFFFUL;
+	resultValue_t result = RESULT_OK;
+
+	// Timer1 counts the CPU clock and captures the falling edges
+	TIMSK1 = 0;
+	TCCR1A = 0;
+	TCCR1B = 0;
+	timer1Config(TIMER1_MODE_NORMAL, TIMER1_PRESCALER_OFF);
+	timer1ClearOverflowInterruptRequest();
+
+	// Waits for the idle line and then for the start bit
+	while(isBitClr(TIMER1_ICP_PIN, TIMER1_ICP) || isBitSet(TIFR1, ICF1)) {
+		timer1ClearInputCaptureInterruptRequest();
+		if(isBitSet(TIFR1, TOV1)) {
+			timer1ClearOverflowInterruptRequest();
+			if(--overflows == 0) {
+				result = RESULT_UNSUPPORTED_USART_BAUD_RATE;
+				break;
+			}
+		}
+	}
+	while((result == RESULT_OK) && isBitClr(TIFR1, ICF1)) {
+		if(isBitSet(TIFR1, TOV1)) {
+			timer1ClearOverflowInterruptRequest();
+			if(--overflows == 0) {
+				result = RESULT_UNSUPPORTED_USART_BAUD_RATE;
+			}
+		}
+	}
+
+	// Timestamps the following edges until the line stays still
+	if(result == RESULT_OK) {
+		sreg = SREG;
+		cli();
+		last = ICR1;
+		setBit(TCCR1B, ICES1);
+		timer1ClearInputCaptureInterruptRequest();
+		while(edges < USART_AUTO_BAUD_EDGES) {
+			while(isBitClr(TIFR1, ICF1) && ((uint16)(TCNT1 - last) < limit))
+				;	// Waits for the next edge
+			if(isBitClr(TIFR1, ICF1))
+				break;	// End of the character
+			aux16 = ICR1;
+			TCCR1B ^= (1 << ICES1);
+			timer1ClearInputCaptureInterruptRequest();
+			intervals[edges] = aux16 - last;
+			last = aux16;
+			if(intervals[edges] < minimum) {
+				minimum = intervals[edges];
+				// No character has more than 10 bits without an edge
+				limit = (minimum < (0xF000 / 10)) ? (minimum * 10) : 0xF000;
+			}
+			edges++;
+		}
+		SREG = sreg;
+		if(edges == 0)
+			result = RESULT_UNSUPPORTED_USART_BAUD_RATE;
+	}
+
+	TIMSK1 = 0;
+	TIFR1 = (1 << ICF1) | (1 << TOV1);
+	TCCR1A = tccr1a;
+	TCCR1B = tccr1b;
+	TIMSK1 = timsk1;
+
+	if(result != RESULT_OK)
+		return result;
+
+	// The shortest interval is one bit; the whole span refines the bit time
+	for(i = 0;i < edges;i++) {
+		span += intervals[i];
+		bits += (intervals[i] + (minimum / 2)) / minimum;
+	}
+
+	// UBRR + 1 = span / (divisor * bits), rounded to the nearest value
+	ubrrSingle = (span + (8 * bits)) / (16 * bits);
+	ubrrDouble = (span + (4 * bits)) / (8 * bits);
+	if((ubrrSingle > 0) && (ubrrSingle <= 4096)) {
+		errorSingle = 16 * ubrrSingle * bits;
+		errorSingle = (errorSingle > span) ? (errorSingle - span) : (span - errorSingle);
+	}
+	if((ubrrDouble > 0) && (ubrrDouble <= 4096)) {
+		errorDouble = 8 * ubrrDouble * bits;
+		errorDouble = (errorDouble > span) ? (errorDouble - span) : (span - errorDouble);
+	}
+	if(errorDouble < errorSingle) {
+		errorSingle = errorDouble;
+		ubrrSingle = ubrrDouble;
+		setBit(UCSR0A, U2X0);
+	} else {
+		clrBit(UCSR0A, U2X0);
+	}
+	if((errorSingle == 0xFFFFFFFFUL) || ((errorSingle * 100) > (span * USART_BAUD_RATE_TOLERANCE)))
+		return RESULT_UNSUPPORTED_USART_BAUD_RATE;
+
+	ubrrSingle--;
+	UBRR0H = (uint8)(0x0F & (ubrrSingle >> 8));
+	UBRR0L = (uint8)(0xFF & ubrrSingle);
+	usartClearReceptionBuffer();		// Discards the sync character
+
+	return RESULT_OK;
+}
+#endif
+
 /* -----------------------------------------------------------------------------
  * Enables USART receiver module
  * -------------------------------------------------------------------------- */
@@ -307,10 +538,10 @@ usartError_t usartCheckError(void)
 		error |= USART_FRAME_ERROR;
 	}
 	if(isBitSet(UCSR0A, DOR0)) {
-		error |= USART_PARITY_ERROR;
+		error |= USART_BUFFER_OVERFLOW_ERROR;
 	}
 	if(isBitSet(UCSR0A, UPE0)) {
-		error |= USART_BUFFER_OVERFLOW_ERROR;
+		error |= USART_PARITY_ERROR;
 	}
 
 	return error;
@@ -439,3 +670,739 @@ int16 usartReceiveStd(FILE * stream)
 
 	return (int16)UDR0;
 }
+
+/* -----------------------------------------------------------------------------
+ * Configures the USART in Master SPI mode (MSPIM). The SCK frequency is the
+ * highest one not above clockSpeed (F_CPU / 2 maximum). The XCK pin is used as
+ * SCK, TXD as MOSI and RXD as MISO; the slave select line must be driven by
+ * the application. The USART interrupts are disabled by this function
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartSpiConfig(usartSpiMode_t mode, usartSpiDataOrder_t dataOrder, uint32 clockSpeed)
+{
+	uint32 ubrr;
+	uint8 reg = (3 << UMSEL00);
+
+	if((clockSpeed == 0) || (clockSpeed > (F_CPU / 2)))
+		return RESULT_UNSUPPORTED_USART_BAUD_RATE;
+	ubrr = ((uint32)F_CPU + (2 * clockSpeed) - 1) / (2 * clockSpeed) - 1;
+	if(ubrr > 4095)
+		return RESULT_UNSUPPORTED_USART_BAUD_RATE;
+
+	switch(mode) {
+	case USART_SPI_MODE_0:
+		break;
+	case USART_SPI_MODE_1:
+		setBit(reg, UCPHA0);
+		break;
+	case USART_SPI_MODE_2:
+		setBit(reg, UCPOL0);
+		break;
+	case USART_SPI_MODE_3:
+		setBit(reg, UCPOL0);
+		setBit(reg, UCPHA0);
+		break;
+	default:
+		return RESULT_UNSUPPORTED_USART_MODE;
+	}
+	if(dataOrder == USART_SPI_LSB_FIRST) {
+		setBit(reg, UDORD0);
+	}
+
+	UBRR0H = 0;
+	UBRR0L = 0;
+	setBit(USART_DDR, USART_XCK);		// XCK must be an output in master mode
+	UCSR0C = reg;
+	UCSR0B = (1 << RXEN0) | (1 << TXEN0);
+	UBRR0H = (uint8)(0x0F & (ubrr >> 8));	// Baud rate must be set after the transmitter is enabled
+	UBRR0L = (uint8)(0xFF & ubrr);
+
+	return RESULT_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Exchanges one byte in Master SPI mode
+ * -------------------------------------------------------------------------- */
+
+uint8 usartSpiTransfer(uint8 data)
+{
+	while(!usartIsBufferEmpty())
+		;	// Waits until the transmit buffer is free
+	UDR0 = data;
+	while(!usartIsReceptionComplete())
+		;	// Waits until the byte is clocked in
+
+	return UDR0;
+}
+
+/* -----------------------------------------------------------------------------
+ * Exchanges a block of bytes in Master SPI mode. The next byte is written to
+ * the double-buffered transmitter while the current one is being shifted, so
+ * SCK runs continuously through the whole block. If txData is NULL, 0xFF is
+ * transmitted; if rxData is NULL, the received bytes are discarded
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartSpiTransferBlock(const uint8 * txData, uint8 * rxData, uint16 size)
+{
+	uint16 txCount = 0;
+	uint16 rxCount = 0;
+	uint8 data;
+
+	while(rxCount < size) {
+		// At most two bytes in flight, so the receiver never overruns
+		if((txCount < size) && ((uint16)(txCount - rxCount) < 2) && usartIsBufferEmpty()) {
+			UDR0 = (txData != NULL) ? txData[txCount] : 0xFF;
+			txCount++;
+		}
+		if(usartIsReceptionComplete()) {
+			data = UDR0;
+			if(rxData != NULL) {
+				rxData[rxCount] = data;
+			}
+			rxCount++;
+		}
+	}
+
+	return RESULT_OK;
+}
+
+#ifdef USART_BUFFERED_MODE
+/* -----------------------------------------------------------------------------
+ * Starts the interrupt-driven operation of the USART. Must be called after
+ * usartConfig() and after the receiver and transmitter are enabled. The
+ * interruptions must be enabled in the main code just after this function is
+ * called
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartBufferedInit(void)
+{
+	usartDeactivateBufferEmptyInterrupt();
+	usartRxBuffer.tail = usartRxBuffer.head;
+	usartTxBuffer.head = usartTxBuffer.tail;
+	usartClearReceptionBuffer();
+	usartActivateReceptionCompleteInterrupt();
+
+	return RESULT_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Queues data to be transmitted by the USART_UDRE_vect handler. Does not
+ * block; returns the number of bytes actually queued, which is smaller than
+ * size if the transmission buffer gets full
+ * -------------------------------------------------------------------------- */
+
+uint16 usartWrite(const uint8 * data, uint16 size)
+{
+	uint16 count = 0;
+
+	while((count < size) && usartTxBufferPush(data[count])) {
+		count++;
+	}
+	if(count > 0) {
+		usartStartTransmission();
+	}
+
+	return count;
+}
+
+/* -----------------------------------------------------------------------------
+ * Reads data received by the USART_RX_vect handler. Does not block; returns
+ * the number of bytes actually read, which is smaller than size if there is
+ * not enough data in the reception buffer
+ * -------------------------------------------------------------------------- */
+
+uint16 usartRead(uint8 * data, uint16 size)
+{
+	uint16 count = 0;
+
+	while((count < size) && usartRxBufferPop(&data[count])) {
+		count++;
+	}
+	usartRtsUpdate();
+
+	return count;
+}
+
+/* -----------------------------------------------------------------------------
+ * Returns the number of bytes waiting in the reception buffer
+ * -------------------------------------------------------------------------- */
+
+uint8 usartGetRxCount(void)
+{
+	return circularBufferSpscGetOccupation(&usartRxBuffer);
+}
+
+/* -----------------------------------------------------------------------------
+ * Returns the number of free bytes in the transmission buffer
+ * -------------------------------------------------------------------------- */
+
+uint8 usartGetTxFree(void)
+{
+	return USART_TX_BUFFER_SIZE - circularBufferSpscGetOccupation(&usartTxBuffer);
+}
+
+/* -----------------------------------------------------------------------------
+ * Changes the std handlers to the buffered usart stream
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartBufferedStdio(void)
+{
+	stdin = stdout = stderr = &usartBufferedStream;
+
+	return RESULT_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Selects what the buffered stream does when the transmission buffer is full
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartSetTxFullPolicy(usartTxFullPolicy_t policy)
+{
+	usartTxFullPolicy = policy;
+	usartTxTruncating = FALSE;
+
+	return RESULT_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Returns the number of bytes dropped by the buffered stream (saturates at
+ * 65535)
+ * -------------------------------------------------------------------------- */
+
+uint16 usartGetDroppedBytes(void)
+{
+	return usartDroppedBytes;
+}
+
+/* -----------------------------------------------------------------------------
+ * Clears the dropped bytes counter of the buffered stream
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartResetDroppedBytes(void)
+{
+	usartDroppedBytes = 0;
+
+	return RESULT_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Queues data in the transmission buffer for the standard output handler.
+ * When the buffer is full, the byte is handled according to the policy set by
+ * usartSetTxFullPolicy(). In USART_TX_FULL_BLOCK policy this function must not
+ * be called with the interruptions disabled
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartTransmitBufferedStd(int8 data, FILE * stream)
+{
+	if(usartTxTruncating) {
+		if((char)data == '\n') {		// The next line starts clean, even if the newline is lost
+			usartTxTruncating = FALSE;
+			if(usartTxBufferPush(data)) {
+				usartStartTransmission();
+				return RESULT_OK;
+			}
+		}
+		if(usartDroppedBytes < 0xFFFF) {
+			usartDroppedBytes++;
+		}
+		return RESULT_OK;
+	}
+
+	while(!usartTxBufferPush(data)) {
+		if(usartTxFullPolicy != USART_TX_FULL_BLOCK) {
+			if(usartDroppedBytes < 0xFFFF) {
+				usartDroppedBytes++;
+			}
+			if((usartTxFullPolicy == USART_TX_FULL_TRUNCATE) && ((char)data != '\n')) {
+				usartTxTruncating = TRUE;
+			}
+			return RESULT_OK;
+		}
+		usartStartTransmission();
+	}
+	usartStartTransmission();
+
+	return RESULT_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Reads data from the reception buffer for the standard input handler. Waits
+ * until data is available
+ * -------------------------------------------------------------------------- */
+
+int16 usartReceiveBufferedStd(FILE * stream)
+{
+	uint8 data;
+
+	while(!usartRxBufferPop(&data))
+		;	// Waits until data is received
+	usartRtsUpdate();
+
+	return (int16)data;
+}
+
+/* -----------------------------------------------------------------------------
+ * Selects how the USART_RX_vect handler frames the received bytes. In
+ * USART_FRAMING_LINE and USART_FRAMING_SLIP the bytes are assembled into one of
+ * two frame buffers while the other one is held by the application, and are
+ * not stored into the reception buffer. Empty lines and frames are ignored
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartSetFraming(usartFraming_t framing)
+{
+	if(framing > USART_FRAMING_SLIP)
+		return RESULT_UNSUPPORTED_VALUE;
+
+	clrBit(UCSR0B, RXCIE0);
+	usartFraming = framing;
+	usartFrameLength = 0;
+	usartFrameDiscarding = FALSE;
+	usartFrameEscape = FALSE;
+	usartFrameReady = FALSE;
+	setBit(UCSR0B, RXCIE0);
+
+	return RESULT_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Hands every received byte to callback, called by the USART_RX_vect handler,
+ * instead of storing it into the reception buffer or the frame buffers. Bytes
+ * with frame or parity errors are not passed. Protocol engines (e.g. Modbus
+ * RTU) use it to process the bytes as they arrive. Passing NULL restores the
+ * normal operation
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartSetReceptionCallback(usartReceptionCallback_t callback)
+{
+	usartReceptionCallback = callback;
+
+	return RESULT_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Returns the frame assembled by the USART_RX_vect handler, or NULL if there is
+ * no complete frame yet. The frame is null-terminated (the line terminator is
+ * removed) and its size is written into size. The buffer belongs to the
+ * application until usartReleaseFrame() is called
+ * -------------------------------------------------------------------------- */
+
+uint8 * usartGetFrame(uint8 * size)
+{
+	if(!usartFrameReady)
+		return NULL;
+
+	*size = usartFrameReadyLength;
+	return usartFrameBuffer[usartFrameWriting ^ 1];
+}
+
+/* -----------------------------------------------------------------------------
+ * Gives the frame returned by usartGetFrame() back to the USART_RX_vect
+ * handler. Frames completed while the application holds the buffer are dropped
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartReleaseFrame(void)
+{
+	usartFrameReady = FALSE;
+
+	return RESULT_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Returns the number of frames dropped because they were too long or because
+ * the previous frame was not released yet (saturates at 65535)
+ * -------------------------------------------------------------------------- */
+
+uint16 usartGetDroppedFrames(void)
+{
+	return usartDroppedFrames;
+}
+
+/* -----------------------------------------------------------------------------
+ * Copies the reception error counters kept by the USART_RX_vect handler
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartGetStatistics(usartStatistics_t * statistics)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		statistics->frameErrors = usartStatistics.frameErrors;
+		statistics->dataOverruns = usartStatistics.dataOverruns;
+		statistics->parityErrors = usartStatistics.parityErrors;
+		statistics->bufferOverflows = usartStatistics.bufferOverflows;
+	}
+
+	return RESULT_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Clears the reception error counters
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartResetStatistics(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		usartStatistics.frameErrors = 0;
+		usartStatistics.dataOverruns = 0;
+		usartStatistics.parityErrors = 0;
+		usartStatistics.bufferOverflows = 0;
+	}
+
+	return RESULT_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Enables the RS-485 half-duplex mode. The driver enable (DE) pin of the
+ * transceiver is asserted when data is queued for transmission, and released
+ * by the USART_TX_vect handler as soon as the last stop bit leaves the
+ * transmitter. The receiver is disabled while DE is asserted, so the echo of
+ * the transmitted bytes is ignored. The receiver enable (/RE) pin may be tied
+ * to DE
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartRs485Config(vuint8 * deDdr, vuint8 * dePort, uint8 deBit)
+{
+	clrBit(*dePort, deBit);
+	setBit(*deDdr, deBit);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		usartRs485Port = dePort;
+		usartRs485Bit = deBit;
+	}
+
+	return RESULT_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Disables the RS-485 half-duplex mode. Waits until the current transmission
+ * ends, so the driver enable pin is released
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartRs485Disable(void)
+{
+	while(usartRs485Port != NULL) {
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+			if(isBitClr(*usartRs485Port, usartRs485Bit)) {		// Not transmitting
+				usartRs485Port = NULL;
+			}
+		}
+	}
+
+	return RESULT_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Enables the RTS/CTS hardware flow control, with active low signals. The RTS
+ * output is deasserted when the reception buffer reaches USART_RTS_HIGH_WATER
+ * bytes and asserted again when it is read down to USART_RTS_LOW_WATER bytes.
+ * The CTS input is sampled before each byte is transmitted; the transmission
+ * stops while it is deasserted and resumes when usartCtsHandler() is called.
+ * Passing NULL as rtsPort or ctsPin disables that direction
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartFlowControlConfig(vuint8 * rtsDdr, vuint8 * rtsPort, uint8 rtsBit, vuint8 * ctsPin, uint8 ctsBit)
+{
+	if(rtsPort != NULL) {
+		clrBit(*rtsPort, rtsBit);		// Ready to receive
+		setBit(*rtsDdr, rtsBit);
+	}
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		usartRtsPort = rtsPort;
+		usartRtsBit = rtsBit;
+		usartCtsPin = ctsPin;
+		usartCtsBit = ctsBit;
+	}
+	usartRtsUpdate();
+
+	return RESULT_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Resumes the transmission when the CTS input is asserted. Must be called by
+ * the pin change interrupt handler of the CTS pin, configured with the
+ * pcintNActivateInterrupt() functions, e.g.:
+ *		ISR(PCINT0_vect)
+ *		{
+ *			usartCtsHandler();
+ *		}
+ * -------------------------------------------------------------------------- */
+
+void usartCtsHandler(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		if((usartCtsPin != NULL) && isBitClr(*usartCtsPin, usartCtsBit) && !circularBufferSpscIsEmpty(&usartTxBuffer)) {
+			setBit(UCSR0B, UDRIE0);
+		}
+	}
+}
+
+/* -----------------------------------------------------------------------------
+ * Enables the multi-processor communication mode. The USART must be configured
+ * with 9 data bits. The receiver ignores every frame until an address frame
+ * (9th bit set) with nodeAddress or USART_MPCM_BROADCAST_ADDRESS is received;
+ * the following data frames are then stored into the reception buffer. Frames
+ * addressed to other nodes are filtered by hardware and cause no interruption
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartMultiprocessorEnable(uint8 nodeAddress)
+{
+	usartNodeAddress = nodeAddress;
+	usartMultiprocessorMode = TRUE;
+	UCSR0A = (UCSR0A & (1 << U2X0)) | (1 << MPCM0);
+
+	return RESULT_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Disables the multi-processor communication mode
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartMultiprocessorDisable(void)
+{
+	usartMultiprocessorMode = FALSE;
+	UCSR0A = (UCSR0A & (1 << U2X0));
+
+	return RESULT_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Ignores the data frames until the next address frame matching this node.
+ * Must be called when the end of the current frame is detected. A frame
+ * addressed to another node also re-arms the filter automatically
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartMultiprocessorRearm(void)
+{
+	UCSR0A = (UCSR0A & (1 << U2X0)) | (1 << MPCM0);
+
+	return RESULT_OK;
+}
+
+/* -----------------------------------------------------------------------------
+ * Transmits an address frame (9th bit set). Waits until the transmission
+ * buffer is drained, so the frame is not mixed with queued data frames. The
+ * payload can then be queued with usartWrite()
+ * -------------------------------------------------------------------------- */
+
+resultValue_t usartMultiprocessorSendAddress(uint8 address)
+{
+	while(!circularBufferSpscIsEmpty(&usartTxBuffer) || isBitSet(UCSR0B, UDRIE0))
+		;	// Waits until queued data is transmitted
+	while(!usartIsBufferEmpty())
+		;	// Waits until last transmission ends
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		if(usartRs485Port != NULL) {
+			clrBit(UCSR0B, TXCIE0);
+			clrBit(UCSR0B, RXEN0);
+			setBit(*usartRs485Port, usartRs485Bit);
+			UCSR0A = (UCSR0A & ((1 << U2X0) | (1 << MPCM0))) | (1 << TXC0);
+		}
+		setBit(UCSR0B, TXB80);
+		UDR0 = address;
+	}
+	while(!usartIsBufferEmpty())
+		;	// Waits until the address frame is moved to the shift register
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		clrBit(UCSR0B, TXB80);
+		if(usartRs485Port != NULL) {
+			setBit(UCSR0B, TXCIE0);		// Releases DE if no payload follows
+		}
+	}
+
+	return RESULT_OK;
+}
+
+// -----------------------------------------------------------------------------
+// Private function definitions ------------------------------------------------
+
+/* -----------------------------------------------------------------------------
+ * Asserts the RTS output again when the reception buffer has been read down to
+ * USART_RTS_LOW_WATER bytes
+ * -------------------------------------------------------------------------- */
+
+static void usartRtsUpdate(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		if((usartRtsPort != NULL) && isBitSet(*usartRtsPort, usartRtsBit) &&
+				((uint8)(usartRxBuffer.head - usartRxBuffer.tail) <= USART_RTS_LOW_WATER)) {
+			clrBit(*usartRtsPort, usartRtsBit);
+		}
+	}
+}
+
+/* -----------------------------------------------------------------------------
+ * Activates the USART_UDRE_vect handler to transmit the queued data. In RS-485
+ * mode, also asserts the driver enable pin and disables the receiver
+ * -------------------------------------------------------------------------- */
+
+static void usartStartTransmission(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		if(usartRs485Port != NULL) {
+			clrBit(UCSR0B, TXCIE0);
+			clrBit(UCSR0B, RXEN0);
+			setBit(*usartRs485Port, usartRs485Bit);
+		}
+		setBit(UCSR0B, UDRIE0);
+	}
+}
+
+/* -----------------------------------------------------------------------------
+ * Increments an error counter, saturating at 65535. Called by the
+ * USART_RX_vect handler only
+ * -------------------------------------------------------------------------- */
+
+static inline void usartStatisticsIncrement(volatile uint16 * counter)
+{
+	if(*counter < 0xFFFF) {
+		(*counter)++;
+	}
+}
+
+/* -----------------------------------------------------------------------------
+ * Adds a received byte to the frame being assembled. Called by the
+ * USART_RX_vect handler only
+ * -------------------------------------------------------------------------- */
+
+static inline void usartFrameReceive(uint8 data)
+{
+	bool_t end = FALSE;
+
+	if(usartFraming == USART_FRAMING_LINE) {
+		end = ((data == '\r') || (data == '\n'));
+	} else if(usartFrameEscape) {
+		usartFrameEscape = FALSE;
+		if(data == USART_SLIP_ESC_END) {
+			data = USART_SLIP_END;
+		} else if(data == USART_SLIP_ESC_ESC) {
+			data = USART_SLIP_ESC;
+		}
+	} else if(data == USART_SLIP_ESC) {
+		usartFrameEscape = TRUE;
+		return;
+	} else {
+		end = (data == USART_SLIP_END);
+	}
+
+	if(!end) {
+		if(usartFrameLength < (USART_FRAME_SIZE - 1)) {
+			usartFrameBuffer[usartFrameWriting][usartFrameLength++] = data;
+		} else {
+			usartFrameDiscarding = TRUE;
+		}
+		return;
+	}
+
+	if(usartFrameDiscarding || ((usartFrameLength > 0) && usartFrameReady)) {
+		if(usartDroppedFrames < 0xFFFF) {
+			usartDroppedFrames++;
+		}
+	} else if(usartFrameLength > 0) {
+		usartFrameBuffer[usartFrameWriting][usartFrameLength] = '\0';
+		usartFrameReadyLength = usartFrameLength;
+		usartFrameWriting ^= 1;
+		usartFrameReady = TRUE;
+	}
+	usartFrameLength = 0;
+	usartFrameDiscarding = FALSE;
+}
+
+// -----------------------------------------------------------------------------
+// Interruption handlers -------------------------------------------------------
+
+/* -----------------------------------------------------------------------------
+ * Handler:		USART_RX_vect
+ * Purpose:		Moves the received byte into the reception buffer, or into the
+ *				frame being assembled if a framing mode is selected. Bytes
+ *				received with frame or parity errors, or when the buffer is
+ *				full, are dropped and counted. In multi-processor
+ *				communication mode, address frames are matched against the
+ *				node address
+ * -------------------------------------------------------------------------- */
+
+ISR(USART_RX_vect)
+{
+	uint8 status = UCSR0A;		// Error flags are valid only before UDR0 is read
+	uint8 control = UCSR0B;
+	uint8 data = UDR0;
+
+	if(isBitSet(status, DOR0)) {	// Bytes were lost before this one
+		usartStatisticsIncrement(&usartStatistics.dataOverruns);
+	}
+	if(isBitSet(status, FE0)) {
+		usartStatisticsIncrement(&usartStatistics.frameErrors);
+		return;
+	}
+	if(isBitSet(status, UPE0)) {
+		usartStatisticsIncrement(&usartStatistics.parityErrors);
+		return;
+	}
+
+	if(usartMultiprocessorMode) {
+		if(isBitSet(control, RXB80)) {		// Address frame
+			if((data == usartNodeAddress) || (data == USART_MPCM_BROADCAST_ADDRESS)) {
+				UCSR0A = (UCSR0A & (1 << U2X0));					// Receives the payload
+			} else {
+				UCSR0A = (UCSR0A & (1 << U2X0)) | (1 << MPCM0);	// Ignores the payload
+			}
+			return;
+		}
+	}
+	if(usartReceptionCallback != NULL) {
+		usartReceptionCallback(data);
+		return;
+	}
+	if(usartFraming != USART_FRAMING_NONE) {
+		usartFrameReceive(data);
+		return;
+	}
+	if(!usartRxBufferPush(data)) {
+		usartStatisticsIncrement(&usartStatistics.bufferOverflows);
+	}
+	if((usartRtsPort != NULL) && ((uint8)(usartRxBuffer.head - usartRxBuffer.tail) >= USART_RTS_HIGH_WATER)) {
+		setBit(*usartRtsPort, usartRtsBit);		// Asks the sender to stop
+	}
+}
+
+/* -----------------------------------------------------------------------------
+ * Handler:		USART_UDRE_vect
+ * Purpose:		Feeds the next queued byte to the transmitter, or deactivates
+ *				itself when the transmission buffer is empty or the CTS input
+ *				is deasserted. In RS-485 mode, the transmission complete flag
+ *				is cleared with every byte, and the USART_TX_vect handler is
+ *				activated after the last one
+ * -------------------------------------------------------------------------- */
+
+ISR(USART_UDRE_vect)
+{
+	uint8 data;
+
+	if((usartCtsPin != NULL) && isBitSet(*usartCtsPin, usartCtsBit)) {
+		clrBit(UCSR0B, UDRIE0);		// Resumed by usartCtsHandler()
+		return;
+	}
+	if(usartTxBufferPop(&data)) {
+		if(usartRs485Port != NULL) {
+			UCSR0A = (UCSR0A & ((1 << U2X0) | (1 << MPCM0))) | (1 << TXC0);
+		}
+		UDR0 = data;
+	} else {
+		clrBit(UCSR0B, UDRIE0);
+		if(usartRs485Port != NULL) {
+			setBit(UCSR0B, TXCIE0);
+		}
+	}
+}
+
+/* -----------------------------------------------------------------------------
+ * Handler:		USART_TX_vect
+ * Purpose:		Releases the RS-485 driver enable pin when the last stop bit
+ *				has been transmitted, and enables the receiver again
+ * -------------------------------------------------------------------------- */
+
+ISR(USART_TX_vect)
+{
+	clrBit(UCSR0B, TXCIE0);
+	if(usartRs485Port != NULL) {
+		clrBit(*usartRs485Port, usartRs485Bit);
+		setBit(UCSR0B, RXEN0);
+	}
+}
+#endif
@@ -3,8 +3,10 @@
  * File:			usart.h
  * Module:			USART interface
  * Author:			Leandro Schwarz
- * Version:			13.0
- * Last edition:	2017-06-17
+ * Build:			1
+ * Last edition:	October 17, 2026
+ * Purpose:			USART0 controller, with optional interrupt-driven ring
+ *					buffers (USART_BUFFERED_MODE)
  * -------------------------------------------------------------------------- */
 
 #ifndef __USART_H
@@ -15,14 +17,90 @@
 
 #include "globalDefines.h"
 #if __GLOBALDEFINES_H != 1
-	#error Error 100 - globalDefines.h - wrong version (globalDefines must be build 1).
+	#error Error 100 - The defintion file is outdated (globalDefines must be build 1).
 #endif
 #include <stdio.h>
 
+// -----------------------------------------------------------------------------
+// Constant definitions --------------------------------------------------------
+
+// Define USART_BUFFERED_MODE to use the interrupt-driven transmitter and
+// receiver (usartWrite() / usartRead()). The module then owns the
+// USART_RX_vect, USART_UDRE_vect and USART_TX_vect interrupt handlers. The
+// ring sizes must be powers of two up to 128 bytes.
+#ifndef USART_RX_BUFFER_SIZE
+	#define USART_RX_BUFFER_SIZE		32
+#endif
+#ifndef USART_TX_BUFFER_SIZE
+	#define USART_TX_BUFFER_SIZE		32
+#endif
+
+// Reception buffer occupation that deasserts (high water) and asserts again
+// (low water) the RTS output when hardware flow control is enabled
+#ifndef USART_RTS_HIGH_WATER
+	#define USART_RTS_HIGH_WATER		((USART_RX_BUFFER_SIZE * 3) / 4)
+#endif
+#ifndef USART_RTS_LOW_WATER
+	#define USART_RTS_LOW_WATER			(USART_RX_BUFFER_SIZE / 4)
+#endif
+
+// Size of each of the two frame buffers used by the reception framing (lines
+// or SLIP frames), including the string terminator
+#ifndef USART_FRAME_SIZE
+	#define USART_FRAME_SIZE			32
+#endif
+
+// Address accepted by every node in multi-processor communication mode
+#ifndef USART_MPCM_BROADCAST_ADDRESS
+	#define USART_MPCM_BROADCAST_ADDRESS	0xFF
+#endif
+
+// Maximum baud rate error, in percent, accepted by usartConfig() in
+// asynchronous modes and by the USART_BAUD_RATE compile-time check
+#ifndef USART_BAUD_RATE_TOLERANCE
+	#define USART_BAUD_RATE_TOLERANCE	2
+#endif
+
+// Define USART_AUTO_BAUD to build usartAutoBaud(), which borrows timer1 and
+// needs the RXD pin wired to the ICP1 pin. USART_AUTO_BAUD_EDGES is the number
+// of edges timed after the start bit (9 for the 0x55 sync character).
+#ifndef USART_AUTO_BAUD_EDGES
+	#define USART_AUTO_BAUD_EDGES		9
+#endif
+
+// Define USART_BAUD_RATE with a constant baud rate to have UBRR0 and the double
+// speed selection computed at compile time (see usartSetConstantBaudRate()).
+// The setting with the lowest error is chosen, and the build fails if the error
+// is above USART_BAUD_RATE_TOLERANCE.
+#ifdef USART_BAUD_RATE
+	#define USART_UBRR_SINGLE_SPEED		((F_CPU + 8UL * (USART_BAUD_RATE)) / (16UL * (USART_BAUD_RATE)) - 1UL)
+	#define USART_UBRR_DOUBLE_SPEED		((F_CPU + 4UL * (USART_BAUD_RATE)) / (8UL * (USART_BAUD_RATE)) - 1UL)
+	#define usartBaudRateError(divisor)	((((divisor) * (USART_BAUD_RATE)) > F_CPU) ?								\
+											(((divisor) * (USART_BAUD_RATE)) - F_CPU) :								\
+											(F_CPU - ((divisor) * (USART_BAUD_RATE))))
+	#define USART_ERROR_SINGLE_SPEED	usartBaudRateError(16UL * (USART_UBRR_SINGLE_SPEED + 1UL))
+	#define USART_ERROR_DOUBLE_SPEED	usartBaudRateError(8UL * (USART_UBRR_DOUBLE_SPEED + 1UL))
+	#if (USART_UBRR_SINGLE_SPEED <= 4095) && ((USART_UBRR_DOUBLE_SPEED > 4095) || (USART_ERROR_SINGLE_SPEED <= USART_ERROR_DOUBLE_SPEED))
+		#define USART_UBRR_VALUE		USART_UBRR_SINGLE_SPEED
+		#define USART_USE_DOUBLE_SPEED	0
+		#define USART_BAUD_RATE_ERROR	USART_ERROR_SINGLE_SPEED
+	#else
+		#define USART_UBRR_VALUE		USART_UBRR_DOUBLE_SPEED
+		#define USART_USE_DOUBLE_SPEED	1
+		#define USART_BAUD_RATE_ERROR	USART_ERROR_DOUBLE_SPEED
+	#endif
+	#if (USART_UBRR_VALUE > 4095) || ((USART_BAUD_RATE_ERROR * 100) > (F_CPU * USART_BAUD_RATE_TOLERANCE))
+		#error Error 103 - usart.h - USART_BAUD_RATE cannot be generated within USART_BAUD_RATE_TOLERANCE from F_CPU.
+	#endif
+#endif
+
 // -----------------------------------------------------------------------------
 // Global variable declarations ------------------------------------------------
 
 extern FILE usartStream;
+#ifdef USART_BUFFERED_MODE
+extern FILE usartBufferedStream;
+#endif
 
 // -----------------------------------------------------------------------------
 // New data types --------------------------------------------------------------
@@ -65,6 +143,39 @@ typedef enum usartMode_t {
 	USART_MODE_NO_CHANGE = 255
 } usartMode_t;
 
+typedef enum usartSpiMode_t {
+	USART_SPI_MODE_0 = 0,			// CPOL = 0, CPHA = 0
+	USART_SPI_MODE_1,				// CPOL = 0, CPHA = 1
+	USART_SPI_MODE_2,				// CPOL = 1, CPHA = 0
+	USART_SPI_MODE_3				// CPOL = 1, CPHA = 1
+} usartSpiMode_t;
+
+typedef enum usartSpiDataOrder_t {
+	USART_SPI_MSB_FIRST = 0,
+	USART_SPI_LSB_FIRST
+} usartSpiDataOrder_t;
+
+typedef enum usartTxFullPolicy_t {
+	USART_TX_FULL_BLOCK = 0,		// Waits until there is room in the buffer
+	USART_TX_FULL_DROP,				// Drops the byte
+	USART_TX_FULL_TRUNCATE			// Drops the rest of the line
+} usartTxFullPolicy_t;
+
+typedef enum usartFraming_t {
+	USART_FRAMING_NONE = 0,			// Received bytes go to the reception buffer
+	USART_FRAMING_LINE,				// Text lines ended by CR and/or LF
+	USART_FRAMING_SLIP				// SLIP frames (RFC 1055)
+} usartFraming_t;
+
+typedef void (* usartReceptionCallback_t)(uint8 data);
+
+typedef struct usartStatistics_t {
+	uint16 frameErrors;				// Bytes dropped due to a wrong stop bit
+	uint16 dataOverruns;			// Hardware receive buffer overruns
+	uint16 parityErrors;			// Bytes dropped due to a parity mismatch
+	uint16 bufferOverflows;			// Bytes dropped because the reception buffer was full
+} usartStatistics_t;
+
 typedef enum usartBaudRate_t {
 	USART_BAUD_600 = 600UL,
 	USART_BAUD_1200 = 1200UL,
@@ -79,6 +190,7 @@ typedef enum usartBaudRate_t {
 	USART_BAUD_57600 = 57600UL,
 	USART_BAUD_115200 = 115200UL,
 	USART_BAUD_128000 = 128000UL,
+	USART_BAUD_250000 = 250000UL,
 	USART_BAUD_256000 = 256000UL,
 	USART_BAUD_NO_CHANGE = 0xFFFFFFFFUL
 } usartBaudRate_t;
@@ -87,6 +199,12 @@ typedef enum usartBaudRate_t {
 // Function declarations -------------------------------------------------------
 
 resultValue_t	usartConfig(usartMode_t mode, usartBaudRate_t baudRate, usartDataBits_t dataBits, usartParity_t parity, usartStopBits_t stopBits);
+#ifdef USART_BAUD_RATE
+resultValue_t	usartSetConstantBaudRate(void);
+#endif
+#ifdef USART_AUTO_BAUD
+resultValue_t	usartAutoBaud(uint16 timeout);
+#endif
 resultValue_t	usartEnableReceiver(void);
 resultValue_t	usartDisableReceiver(void);
 resultValue_t	usartEnableTransmitter(void);
@@ -112,5 +230,36 @@ void			usartClearReceptionBuffer(void);
 resultValue_t	usartStdio(void);
 resultValue_t	usartTransmitStd(int8 data, FILE * stream);
 int16			usartReceiveStd(FILE * stream);
+resultValue_t	usartSpiConfig(usartSpiMode_t mode, usartSpiDataOrder_t dataOrder, uint32 clockSpeed);
+uint8			usartSpiTransfer(uint8 data);
+resultValue_t	usartSpiTransferBlock(const uint8 * txData, uint8 * rxData, uint16 size);
+#ifdef USART_BUFFERED_MODE
+resultValue_t	usartBufferedInit(void);
+uint16			usartWrite(const uint8 * data, uint16 size);
+uint16			usartRead(uint8 * data, uint16 size);
+uint8			usartGetRxCount(void);
+uint8			usartGetTxFree(void);
+resultValue_t	usartBufferedStdio(void);
+resultValue_t	usartSetTxFullPolicy(usartTxFullPolicy_t policy);
+uint16			usartGetDroppedBytes(void);
+resultValue_t	usartResetDroppedBytes(void);
+resultValue_t	usartTransmitBufferedStd(int8 data, FILE * stream);
+int16			usartReceiveBufferedStd(FILE * stream);
+resultValue_t	usartSetReceptionCallback(usartReceptionCallback_t callback);
+resultValue_t	usartSetFraming(usartFraming_t framing);
+uint8 *			usartGetFrame(uint8 * size);
+resultValue_t	usartReleaseFrame(void);
+uint16			usartGetDroppedFrames(void);
+resultValue_t	usartGetStatistics(usartStatistics_t * statistics);
+resultValue_t	usartResetStatistics(void);
+resultValue_t	usartRs485Config(vuint8 * deDdr, vuint8 * dePort, uint8 deBit);
+resultValue_t	usartRs485Disable(void);
+resultValue_t	usartFlowControlConfig(vuint8 * rtsDdr, vuint8 * rtsPort, uint8 rtsBit, vuint8 * ctsPin, uint8 ctsBit);
+void			usartCtsHandler(void);
+resultValue_t	usartMultiprocessorEnable(uint8 nodeAddress);
+resultValue_t	usartMultiprocessorDisable(void);
+resultValue_t	usartMultiprocessorRearm(void);
+resultValue_t	usartMultiprocessorSendAddress(uint8 address);
+#endif
 
 #endif